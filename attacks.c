@@ -52,9 +52,74 @@ U64 AttacksTo(sPosition *p, int sq)
 
 int IsAttacked(sPosition *p, int sq, int side)
 {
+#ifdef USE_ATTACK_MAPS
+  return (p->bbAttacks[side] & SqBb(sq)) != 0;
+#else
   return (bbPc(p, side, P) & bbPawnAttacks[Opp(side)][sq]) ||
          (bbPc(p, side, N) & bbKnightAttacks[sq]) ||
          ((bbPc(p, side, B) | bbPc(p, side, Q)) & BAttacks(OccBb(p), sq)) ||
          ((bbPc(p, side, R) | bbPc(p, side, Q)) & RAttacks(OccBb(p), sq)) ||
          (bbPc(p, side, K) & bbKingAttacks[sq]);
+#endif
 }
+
+#ifdef USE_ATTACK_MAPS
+
+// Attack maps (compiled with -DUSE_ATTACK_MAPS). Every piece keeps its own
+// attack set in bbAttFrom[], and the sets of each side are merged into
+// bbAttacks[] after every move. A move changes the occupancy of a few
+// squares only, so apart from the pieces standing on them we have to look
+// again only at the sliders whose rays reached one of these squares: a ray
+// blocked before reaching a changed square is blocked by a square that has
+// not changed, hence it stays the same.
+
+void InitAttackMaps(sPosition *p)
+{
+  for (int sq = 0; sq < 64; sq++)
+    p->bbAttFrom[sq] = AttacksFrom(p, sq);
+  SumAttackMaps(p);
+}
+
+// called after the board has been updated, both on making and unmaking a move
+
+void UpdateAttackMaps(sPosition *p, U64 bbChanged)
+{
+  U64 bbSliders = (p->bbTp[B] | p->bbTp[R] | p->bbTp[Q]) & ~bbChanged;
+
+  while (bbSliders) {
+    int sq = PopFirstBit(&bbSliders);
+    if (p->bbAttFrom[sq] & bbChanged)
+      p->bbAttFrom[sq] = AttacksFrom(p, sq);
+  }
+
+  while (bbChanged) {
+    int sq = PopFirstBit(&bbChanged);
+    p->bbAttFrom[sq] = AttacksFrom(p, sq); // empty square gives no attacks
+  }
+}
+
+void SumAttackMaps(sPosition *p)
+{
+  for (int side = WHITE; side <= BLACK; side++) {
+    U64 bbPieces = p->bbCl[side] & ~p->bbTp[P];
+    p->bbPawnAtt[side] = GetPawnAttacks(side, bbPc(p, side, P));
+    p->bbAttacks[side] = p->bbPawnAtt[side];
+    while (bbPieces)
+      p->bbAttacks[side] |= p->bbAttFrom[PopFirstBit(&bbPieces)];
+  }
+
+  // pieces giving check
+  int ksq  = KingSq(p, p->side);
+  int oppo = Opp(p->side);
+  p->bbCheckers = 0;
+  if (p->bbAttacks[oppo] & SqBb(ksq)) {
+    U64 bbPieces = p->bbCl[oppo] & ~p->bbTp[P];
+    p->bbCheckers = bbPc(p, oppo, P) & bbPawnAttacks[p->side][ksq];
+    while (bbPieces) {
+      int sq = PopFirstBit(&bbPieces);
+      if (p->bbAttFrom[sq] & SqBb(ksq)) p->bbCheckers |= SqBb(sq);
+    }
+  }
+}
+
+#endif
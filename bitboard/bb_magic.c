@@ -0,0 +1,219 @@
+/*
+  Rodent, a UCI chess playing engine derived from Sungorus 1.4
+  Copyright (C) 2009-2011 Pablo Vazquez (Sungorus author)
+  Copyright (C) 2011-2014 Pawel Koziol
+
+  Rodent is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published 
+  by the Free Software Foundation, either version 3 of the License, 
+  or (at your option) any later version.
+
+  Rodent is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty 
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Fancy magic bitboards and their PEXT counterpart. Both backends share
+// sMagic entries and differ only in the way occupancy is turned into an index,
+// so switching between them means rebuilding the tables.
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#elif defined(__x86_64__)
+#  include <cpuid.h>
+#endif
+#include <stdio.h>
+#include "bitboard.h"
+#include "../rodent.h"
+#include "../timer.h"
+
+static const U64 rookMagicNumbers[64] = {
+  0x0080021620804001ULL, 0x0040001000200041ULL, 0x0200102200088040ULL, 0x4080040800821000ULL,
+  0x2200020004200810ULL, 0x4B00020C000D0008ULL, 0x01000C4183000600ULL, 0x2080010000402C80ULL,
+  0x8002800826864000ULL, 0x0410802000884000ULL, 0x0C01004010200100ULL, 0x020300100100203CULL,
+  0x0450800801040080ULL, 0x4010800200040080ULL, 0x8804000208048110ULL, 0x0C40800080004100ULL,
+  0xA2018880024004A0ULL, 0x0080848020004004ULL, 0x1010410010200101ULL, 0x2010008008008010ULL,
+  0x0A08010004110008ULL, 0x0802080104209040ULL, 0x0080040090010802ULL, 0x0280020000841069ULL,
+  0x080C400080248000ULL, 0x2048850100224008ULL, 0x00200800C0300040ULL, 0x11400D0100201000ULL,
+  0x0041001100080204ULL, 0x4802000200040810ULL, 0x0100080C00103601ULL, 0x0020084200043085ULL,
+  0x0100804000800022ULL, 0x0460401000402002ULL, 0x8309002001001044ULL, 0x0000800800801000ULL,
+  0x0000800800800400ULL, 0xB542040080800200ULL, 0x1041000401000200ULL, 0x000318B04A000401ULL,
+  0x0280082000484000ULL, 0x0080400081010030ULL, 0x0010002000108080ULL, 0x012010002101000AULL,
+  0x0801000408010012ULL, 0x0004008002008004ULL, 0x0AD1005200110014ULL, 0x4000004110820004ULL,
+  0x9400400080003080ULL, 0x0000802200490200ULL, 0x1521100080200280ULL, 0x9021000824100100ULL,
+  0x0081080080840280ULL, 0x0002000904100200ULL, 0x0130024801302400ULL, 0x0102008100442200ULL,
+  0x0080984063800101ULL, 0x0016810201412812ULL, 0x40200101603008C1ULL, 0x2851100004082101ULL,
+  0x1049001002880005ULL, 0x0081000804000201ULL, 0x100020901208410CULL, 0x0101064400813102ULL
+};
+
+static const U64 bishopMagicNumbers[64] = {
+  0x24E0440C00802202ULL, 0x00881808841A4500ULL, 0x29C1021085004190ULL, 0x18C4041080042020ULL,
+  0x0841104000008108ULL, 0x890828080880C088ULL, 0x0006021024062018ULL, 0x2000404044104040ULL,
+  0x09000504104A0210ULL, 0x0088390204040820ULL, 0x4001420082008402ULL, 0x028108048B001142ULL,
+  0x1C00140421001008ULL, 0x0008021212200400ULL, 0x080000581A082004ULL, 0x3000048208027204ULL,
+  0x0120004044148482ULL, 0x4021000808108090ULL, 0x0084011808009452ULL, 0x11C802242020E000ULL,
+  0x0124002210140002ULL, 0x4009008200420200ULL, 0x0000830202100202ULL, 0x9002042500420200ULL,
+  0x0A60200004480210ULL, 0x0402481020480080ULL, 0x8001100101004200ULL, 0x6240104004004080ULL,
+  0x1124848014002000ULL, 0x00180200204100A0ULL, 0x8020890844880800ULL, 0x0000802009040204ULL,
+  0x0410042041100280ULL, 0x0804022000020440ULL, 0x2418280400480024ULL, 0x0801080800420A00ULL,
+  0x4002248400020020ULL, 0x3020004102038084ULL, 0x84280110601C0200ULL, 0x2004004208088080ULL,
+  0x0008022220041210ULL, 0x00820E0120000440ULL, 0x0002002201020822ULL, 0x0000002019000804ULL,
+  0x0211204C10101100ULL, 0x0604808081001200ULL, 0x1010029204030041ULL, 0x1008090102110621ULL,
+  0x0002015002100C00ULL, 0x06002C040404400AULL, 0xC030002201100011ULL, 0x4040008020884000ULL,
+  0x0248000903040100ULL, 0xC010092008008040ULL, 0x6008084108020494ULL, 0x28102182008E0042ULL,
+  0x0010210820842002ULL, 0x4080020111491002ULL, 0x0108100084008800ULL, 0x0022242100420221ULL,
+  0x10A8008110020210ULL, 0x400019122A900102ULL, 0x00800A1051080300ULL, 0x0420222088008080ULL
+};
+
+static U64 rookTable[0x19000];   // 102400 entries: sum of 2^PopCnt(mask) over all squares
+static U64 bishopTable[0x1480];  // 5248 entries
+
+sMagic rookMagic[64];
+sMagic bishopMagic[64];
+int sliderBackend;
+
+#if defined(_MSC_VER)
+#  define CpuId(leaf, r) __cpuidex((int *)(r), leaf, 0)
+#elif defined(USE_PEXT)
+#  define CpuId(leaf, r) __cpuid_count(leaf, 0, (r)[0], (r)[1], (r)[2], (r)[3])
+#endif
+
+// Returns 0 if the cpu lacks PEXT, 1 if it is slow and 2 if it is fast.
+// PEXT is fast on Intel since Haswell and on AMD since Zen 3. Earlier
+// Zen cores execute it in microcode, much slower than a magic lookup.
+
+static int PextSupport(void)
+{
+#ifdef USE_PEXT
+  unsigned int reg[4]; // eax, ebx, ecx, edx
+
+  CpuId(0, reg);
+  int maxLeaf = reg[0];
+  int isAmd = (reg[1] == 0x68747541); // "Auth" of "AuthenticAMD"
+  if (maxLeaf < 7) return 0;
+
+  CpuId(7, reg);
+  if (!(reg[1] & (1 << 8))) return 0; // no BMI2
+
+  if (isAmd) {
+    CpuId(1, reg);
+    int family = ((reg[0] >> 8) & 0xF) + ((reg[0] >> 20) & 0xFF);
+    if (family < 0x19) return 1;
+  }
+  return 2;
+#else
+  return 0;
+#endif
+}
+
+int BestSliderBackend(void)
+{
+  return (PextSupport() == 2) ? SLIDERS_PEXT : SLIDERS_MAGIC;
+}
+
+static U64 *InitMagics(sMagic *m, U64 *table, const U64 *magicNumbers, int isRook, int backend)
+{
+  for (int sq = 0; sq < 64; sq++) {
+
+    // edges do not block anything, unless the slider stands on them
+    U64 bbEdges = ((bbRANK_1 | bbRANK_8) & ~bbLineMask[HOR][sq])
+                | ((bbFILE_A | bbFILE_H) & ~bbLineMask[VER][sq]);
+
+    m[sq].mask  = (isRook ? KgRAttacks(0ULL, sq) : KgBAttacks(0ULL, sq)) & ~bbEdges;
+    m[sq].magic = magicNumbers[sq];
+    m[sq].shift = 64 - PopCnt(m[sq].mask);
+    m[sq].table = table;
+
+    // visit all subsets of the mask
+    U64 bbOcc = 0;
+    do {
+      U64 index;
+#ifdef USE_PEXT
+      if (backend == SLIDERS_PEXT) index = Pext(bbOcc, m[sq].mask);
+      else
+#endif
+      index = (bbOcc * m[sq].magic) >> m[sq].shift;
+      table[index] = isRook ? KgRAttacks(bbOcc, sq) : KgBAttacks(bbOcc, sq);
+      bbOcc = (bbOcc - m[sq].mask) & m[sq].mask;
+    } while (bbOcc);
+
+    table += (U64)1 << PopCnt(m[sq].mask);
+  }
+  return table;
+}
+
+// needs kindergarten tables, so it must be called after InitKindergartenBitboards()
+
+void InitSliderAttacks(int backend)
+{
+#ifndef USE_PEXT
+  backend = SLIDERS_MAGIC;
+#endif
+  sliderBackend = backend;
+  InitMagics(rookMagic, rookTable, rookMagicNumbers, 1, backend);
+  InitMagics(bishopMagic, bishopTable, bishopMagicNumbers, 0, backend);
+}
+
+// Microbenchmark of queen attack lookups for all backends, run by the
+// "sliderbench" command. Occupancies are random with about 1/4 of squares
+// filled; the checksum must be the same for every backend.
+
+#define BENCH_CASES  4096
+#define BENCH_ROUNDS 16384
+
+static U64 benchOcc[BENCH_CASES];
+static int benchSq[BENCH_CASES];
+
+static void ReportSliders(const char *name, int time, U64 checksum)
+{
+  double lookups = 2.0 * BENCH_CASES * BENCH_ROUNDS;
+  printf("%-13s %6d ms %8.1f M lookups/s  checksum %016llx\n",
+         name, time, time ? lookups / (time * 1000.0) : 0.0, (unsigned long long) checksum);
+}
+
+static void BenchBackend(const char *name, int backend)
+{
+  U64 checksum = 0;
+
+  InitSliderAttacks(backend);
+  int start = Timer.GetMS();
+  for (int r = 0; r < BENCH_ROUNDS; r++)
+    for (int i = 0; i < BENCH_CASES; i++)
+      checksum += QAttacks(benchOcc[i], benchSq[i]);
+  ReportSliders(name, Timer.GetMS() - start, checksum);
+}
+
+void BenchSliders(void)
+{
+  int inUse = sliderBackend;
+  U64 state = 1, checksum = 0;
+
+  for (int i = 0; i < BENCH_CASES; i++) { // xorshift, so that Random64() sequence stays untouched
+    U64 bb = ~0ULL;
+    for (int j = 0; j < 2; j++) {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      bb &= state;
+    }
+    benchSq[i]  = (int)(state >> 58);
+    benchOcc[i] = bb | SqBb(benchSq[i]);
+  }
+
+  int start = Timer.GetMS();
+  for (int r = 0; r < BENCH_ROUNDS; r++)
+    for (int i = 0; i < BENCH_CASES; i++)
+      checksum += KgRAttacks(benchOcc[i], benchSq[i]) | KgBAttacks(benchOcc[i], benchSq[i]);
+  ReportSliders("kindergarten", Timer.GetMS() - start, checksum);
+
+  BenchBackend("magic", SLIDERS_MAGIC);
+#ifdef USE_PEXT
+  if (PextSupport()) BenchBackend("pext", SLIDERS_PEXT);
+  else printf("pext          not supported by this cpu\n");
+#endif
+
+  InitSliderAttacks(inUse);
+  printf("in use: %s\n", inUse == SLIDERS_PEXT ? "pext" : "magic");
+}
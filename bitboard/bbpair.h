@@ -0,0 +1,129 @@
+/*
+  Rodent, a UCI chess playing engine derived from Sungorus 1.4
+  Copyright (C) 2009-2011 Pablo Vazquez (Sungorus author)
+  Copyright (C) 2011-2014 Pawel Koziol
+
+  Rodent is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  Rodent is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Pairs of bitboards, one for each color, for evaluation terms that do
+   the same work for both sides. On 64-bit x86 a pair is kept in one SSE2
+   register (white in the low lane); with AVX2 the opposite shifts of the
+   two lanes are done by single variable-shift instructions. Elsewhere, or
+   when compiled with -DNO_SIMD_EVAL, a pair is just two words. All the
+   versions give the same bitboards, so evaluation and search do not
+   depend on the choice.
+
+   "Forward" is towards the 8th rank for white and the 1st rank for black.
+*/
+
+#pragma once
+
+#if !defined(NO_SIMD_EVAL) \
+ && ( (defined(__SSE2__) && defined(__x86_64__)) || defined(_M_X64) || defined(_M_AMD64) )
+#  define USE_SIMD_EVAL
+#  include <emmintrin.h>
+#  if defined(__AVX2__)
+#    include <immintrin.h>
+#  endif
+#endif
+
+struct sBbPair {
+#ifdef USE_SIMD_EVAL
+  __m128i v;
+#else
+  U64 bb[2];
+#endif
+};
+
+#ifdef USE_SIMD_EVAL
+
+static FORCEINLINE sBbPair PairMake(U64 white, U64 black) {
+  sBbPair r; r.v = _mm_set_epi64x((long long)black, (long long)white); return r;
+}
+
+static FORCEINLINE sBbPair PairLoad(const U64 *bb) { // bb[WHITE], bb[BLACK]
+  sBbPair r; r.v = _mm_loadu_si128((const __m128i *)bb); return r;
+}
+
+static FORCEINLINE void PairStore(U64 *bb, sBbPair a) {
+  _mm_storeu_si128((__m128i *)bb, a.v);
+}
+
+static FORCEINLINE U64 PairWhite(sBbPair a) { return (U64)_mm_cvtsi128_si64(a.v); }
+static FORCEINLINE U64 PairBlack(sBbPair a) { return (U64)_mm_cvtsi128_si64(_mm_unpackhi_epi64(a.v, a.v)); }
+
+static FORCEINLINE sBbPair PairSwap(sBbPair a) { // each side gets the board of the other one
+  sBbPair r; r.v = _mm_shuffle_epi32(a.v, 0x4E); return r;
+}
+
+static FORCEINLINE sBbPair PairOr(sBbPair a, sBbPair b)     { sBbPair r; r.v = _mm_or_si128(a.v, b.v);     return r; }
+static FORCEINLINE sBbPair PairAnd(sBbPair a, sBbPair b)    { sBbPair r; r.v = _mm_and_si128(a.v, b.v);    return r; }
+static FORCEINLINE sBbPair PairAndNot(sBbPair a, sBbPair b) { sBbPair r; r.v = _mm_andnot_si128(b.v, a.v); return r; } // a & ~b
+
+// white lane shifted left by w bits, black lane shifted right by b bits
+
+#if defined(__AVX2__)
+#  define PAIR_SHIFT(x, w, b) _mm_or_si128(_mm_sllv_epi64(x, _mm_set_epi64x(64, w)), \
+                                           _mm_srlv_epi64(x, _mm_set_epi64x(b, 64)))
+#else
+#  define PAIR_SHIFT(x, w, b) _mm_or_si128(_mm_and_si128(_mm_slli_epi64(x, w), _mm_set_epi64x(0, -1)), \
+                                           _mm_and_si128(_mm_srli_epi64(x, b), _mm_set_epi64x(-1, 0)))
+#endif
+
+static FORCEINLINE sBbPair PairFwd(sBbPair a) {
+  sBbPair r; r.v = PAIR_SHIFT(a.v, 8, 8); return r;
+}
+
+static FORCEINLINE sBbPair PairFillFwd(sBbPair a) { // inclusive fill, like FillNorth() / FillSouth()
+  sBbPair r;
+  r.v = _mm_or_si128(a.v, PAIR_SHIFT(a.v, 8, 8));
+  r.v = _mm_or_si128(r.v, PAIR_SHIFT(r.v, 16, 16));
+  r.v = _mm_or_si128(r.v, PAIR_SHIFT(r.v, 32, 32));
+  return r;
+}
+
+static FORCEINLINE sBbPair PairPawnAttacks(sBbPair a) { // like GetWPControl() and GetBPControl()
+  __m128i notA = _mm_and_si128(a.v, _mm_set1_epi64x((long long)bbNotA));
+  __m128i notH = _mm_and_si128(a.v, _mm_set1_epi64x((long long)bbNotH));
+  sBbPair r; r.v = _mm_or_si128(PAIR_SHIFT(notA, 7, 9), PAIR_SHIFT(notH, 9, 7)); return r;
+}
+
+#undef PAIR_SHIFT
+
+#else // scalar version
+
+static FORCEINLINE sBbPair PairMake(U64 white, U64 black) {
+  sBbPair r; r.bb[0] = white; r.bb[1] = black; return r;
+}
+
+static FORCEINLINE sBbPair PairLoad(const U64 *bb) { return PairMake(bb[0], bb[1]); }
+static FORCEINLINE void PairStore(U64 *bb, sBbPair a) { bb[0] = a.bb[0]; bb[1] = a.bb[1]; }
+
+static FORCEINLINE U64 PairWhite(sBbPair a) { return a.bb[0]; }
+static FORCEINLINE U64 PairBlack(sBbPair a) { return a.bb[1]; }
+
+static FORCEINLINE sBbPair PairSwap(sBbPair a) { return PairMake(a.bb[1], a.bb[0]); }
+
+static FORCEINLINE sBbPair PairOr(sBbPair a, sBbPair b)     { return PairMake(a.bb[0] | b.bb[0], a.bb[1] | b.bb[1]); }
+static FORCEINLINE sBbPair PairAnd(sBbPair a, sBbPair b)    { return PairMake(a.bb[0] & b.bb[0], a.bb[1] & b.bb[1]); }
+static FORCEINLINE sBbPair PairAndNot(sBbPair a, sBbPair b) { return PairMake(a.bb[0] & ~b.bb[0], a.bb[1] & ~b.bb[1]); }
+
+static FORCEINLINE sBbPair PairFwd(sBbPair a)         { return PairMake(ShiftNorth(a.bb[0]), ShiftSouth(a.bb[1])); }
+static FORCEINLINE sBbPair PairFillFwd(sBbPair a)     { return PairMake(FillNorth(a.bb[0]), FillSouth(a.bb[1])); }
+static FORCEINLINE sBbPair PairPawnAttacks(sBbPair a) { return PairMake(GetWPControl(a.bb[0]), GetBPControl(a.bb[1])); }
+
+#endif
+
+static FORCEINLINE sBbPair PairBroadcast(U64 bb) { return PairMake(bb, bb); }
@@ -157,6 +157,31 @@ int PopNextBit(int side, U64 *bb);
 int PopFlippedBit(U64 * bb);
 int FirstOneAsm(U64 bb);
 
+// Color-specialized versions of pawn and serialization helpers, for code
+// that knows the side at compile time (side 0 is white, as in eColor).
+// Functions above that take side as an argument are kept for evaluation.
+
+template <int side> static FORCEINLINE U64 ShiftFwd(U64 bb) {
+    return side == 0 ? ShiftNorth(bb) : ShiftSouth(bb);
+}
+
+template <int side> static FORCEINLINE U64 GetFrontSpan(U64 bb) {
+    return side == 0 ? FillNorthExcl(bb) : FillSouthExcl(bb);
+}
+
+template <int side> static FORCEINLINE U64 GetRearSpan(U64 bb) {
+    return side == 0 ? FillSouthExcl(bb) : FillNorthExcl(bb);
+}
+
+template <int side> static FORCEINLINE U64 GetPawnAttacks(U64 bb) {
+    return side == 0 ? GetWPControl(bb) : GetBPControl(bb);
+}
+
+// white pieces are serialized from the 8th rank down, black ones from the 1st rank up
+template <int side> static FORCEINLINE int PopNextBit(U64 *bb) {
+    return side == 0 ? PopFlippedBit(bb) : PopFirstBit(bb);
+}
+
 void InitKindergartenBitboards(void);
 void InitPawnAttacks(void);
 void InitKnightAttacks(void);
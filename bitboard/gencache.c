@@ -21,6 +21,19 @@
 #include "bitboard.h"
 #include "gencache.h"
 
+// Entries for an empty board must be filled in advance: a zeroed slot would
+// match empty relevant occupancy and return no moves at all.
+
+void sGenCache::Init(void)
+{
+   for (int sq = 0; sq < 64; sq++) {
+      bbROcc[sq] = 0;
+      bbRMob[sq] = RAttacks((U64)0, sq);
+      bbBOcc[sq] = 0;
+      bbBMob[sq] = BAttacks((U64)0, sq);
+   }
+}
+
 U64 sGenCache::GetRookMob(U64 bbOccupied, int sq) 
 {
    // generate mobility bitboard or read it from a table
@@ -26,9 +26,10 @@ private:
   U64 bbBOcc[64];        
   U64 bbBMob[64];
 public:
+  void Init(void);
   U64 GetRookMob(U64 bbOccupied, int sq);
   U64 GetBishMob(U64 bbOccupied, int sq);
   U64 GetQueenMob(U64 bbOccupied, int sq);
 };
 
-extern sGenCache GenCache;
+extern THREAD_LOCAL sGenCache GenCache;
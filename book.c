@@ -561,11 +561,6 @@ void sBook::PrintMissingMoves(sPosition *p) {
     while ( move = Selector.NextMove(0, &flagMoveType) ) {
 
 	   Manipulator.DoMove(p, move, undoData);    
-	
-	   if (IllegalPosition(p)) { 
-		  Manipulator.UndoMove(p, move, undoData); 
-		  continue; 
-	   }
      
        if (GetPolyglotMove(p, 0)) {
           printf("info string missing ");
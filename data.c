@@ -47,7 +47,8 @@ const int bitTable[64] = {
 U64 zobPiece[12][64];
 U64 zobCastle[16];
 U64 zobEp[8];
-int pondering;
+volatile int pondering;
+volatile int stopSearch;
 char ponder_str[6];
 
 const int safety[ 256 ] = { // handmade king safety values
@@ -100,14 +101,10 @@ void sData::InitSinglePiece(int pc, int mat, int del, int phase)
 void sData::InitMobBonus(void) 
 {
    for (int i = 0; i < 28; i++) {
-      mobBonusMg[N][i] = n_mob_mg[i];
-      mobBonusEg[N][i] = n_mob_eg[i];
-      mobBonusMg[B][i] = b_mob_mg[i];
-      mobBonusEg[B][i] = b_mob_eg[i];
-      mobBonusMg[R][i] = r_mob_mg[i];
-      mobBonusEg[R][i] = r_mob_eg[i];
-      mobBonusMg[Q][i] = q_mob_mg[i];
-      mobBonusEg[Q][i] = q_mob_eg[i];
+      mobBonus[N][i] = MakeScore(n_mob_mg[i], n_mob_eg[i]);
+      mobBonus[B][i] = MakeScore(b_mob_mg[i], b_mob_eg[i]);
+      mobBonus[R][i] = MakeScore(r_mob_mg[i], r_mob_eg[i]);
+      mobBonus[Q][i] = MakeScore(q_mob_mg[i], q_mob_eg[i]);
    }
 }
 
@@ -153,11 +150,13 @@ void sData::InitOptions(void) // init user-accessible stuff
    elo          = MAX_ELO; // no weakening
    contempt     = 12;
    isAnalyzing  = 0;  
+   multiPv      = 1;
    useBook      = 1;
    useWeakening = 0;
    useLearning  = 0;
    bookFilter   = 10;
    lazyMargin   = 220;
+   pawnHash     = 4;
 }
 
 // used at the beginning of search to set scaling factors for eval components
@@ -31,12 +31,10 @@ public:
  int deltaValue[7];
  int phaseValue[7];
  int distance[64][64];
- int pstMg[2][6][64];
- int pstEg[2][6][64];
+ int pst[2][6][64];                         // packed midgame/endgame scores
  int outpost[2][6][64];
- int pawnProperty [PAWN_PROPERTIES][2][2][64];
- int mobBonusMg[6][28];
- int mobBonusEg[6][28];
+ int pawnProperty [PAWN_PROPERTIES][2][64]; // packed
+ int mobBonus[6][28];                       // packed
  int mobSidePercentage[2];
  int attSidePercentage[2];
  int ownMobility;
@@ -57,9 +55,11 @@ public:
  int deltaMargin;      // margin for a delta pruning in quiescence search 
  int goodCaptMargin;   // margin of a loss that can be incurred without classifying capture as "bad"
  int lazyMargin;       // margin for lazy evaluation cutoff
+ int pawnHash;         // size of the pawn hash table of each thread, in megabytes
  int verbose;          // shall we output more information about search than bare minimum?
  int useLearning;      // shall we use position learning?
  int isAnalyzing;
+ int multiPv;          // number of best lines shown in analysis
  int useBook;
 
  // book data
@@ -19,8 +19,10 @@
 
 #include <stdio.h>
 #include "../bitboard/bitboard.h"
+#include "../bitboard/bbpair.h"
 #include "../data.h"
 #include "../rodent.h"
+#include "../trans.h"
 #include "eval.h"
 #include <algorithm>
 
@@ -31,11 +33,9 @@ const int egTwoOnSeventh  = 10;
 
 void sEvaluator::InitStaticScore(void) 
 {
-   mgScore            = 0;   egScore            = 0;  // clear midgame/endgame score component
-   pawnScoreMg[WHITE] = 0;   pawnScoreMg[BLACK] = 0;  // clear midgame pawn scores
-   pawnScoreEg[WHITE] = 0;   pawnScoreEg[BLACK] = 0;  // clear endgame pawn scores	 
-   passerScoreMg[WHITE] = 0;   passerScoreMg[BLACK] = 0;  // clear midgame pawn scores
-   passerScoreEg[WHITE] = 0;   passerScoreEg[BLACK] = 0;  // clear endgame pawn scores
+   phasedScore        = 0;                            // clear midgame/endgame score component
+   pawnScore[WHITE]   = 0;   pawnScore[BLACK]   = 0;  // clear pawn scores
+   passerScore[WHITE] = 0;   passerScore[BLACK] = 0;  // clear passed pawn scores
 }
 
 void sEvaluator::InitDynamicScore(sPosition *p) 
@@ -45,14 +45,12 @@ void sEvaluator::InitDynamicScore(sPosition *p)
    attCount[WHITE]         = 0;   attCount[BLACK]    = 0;
    attWood[WHITE]          = 0;   attWood[BLACK] = 0;
    checkCount[WHITE]       = 0;   checkCount[BLACK]  = 0;
-   mgMisc[WHITE]           = 0;   mgMisc[BLACK]      = 0;  // clear miscelanneous midgame scores
-   egMisc[WHITE]           = 0;   egMisc[BLACK]      = 0;  // clear miscelanneous endgame scores
-   mgMobility[WHITE]       = 0;   mgMobility[BLACK]  = 0;  // clear midgame mobility
-   egMobility[WHITE]       = 0;   egMobility[BLACK]  = 0;  // clear endgame mobility	 
-   bbPawnTakes[WHITE]    = GetWPControl( bbPc(p, WHITE, P) );
-   bbPawnTakes[BLACK]    = GetBPControl( bbPc(p, BLACK, P) );
-   bbPawnCanTake[WHITE] = FillNorth( bbPawnTakes[WHITE] );
-   bbPawnCanTake[BLACK] = FillSouth( bbPawnTakes[BLACK] );
+   misc[WHITE]             = 0;   misc[BLACK]        = 0;  // clear miscelanneous scores
+   mobility[WHITE]         = 0;   mobility[BLACK]    = 0;  // clear mobility
+   bbPawnTakes[WHITE]    = pawnEntry->bbPawnTakes[WHITE]; // pawn data come from EvalPawns()
+   bbPawnTakes[BLACK]    = pawnEntry->bbPawnTakes[BLACK];
+   bbPawnCanTake[WHITE]  = pawnEntry->bbPawnCanTake[WHITE];
+   bbPawnCanTake[BLACK]  = pawnEntry->bbPawnCanTake[BLACK];
    bbAllAttacks[WHITE]     = bbPawnTakes[WHITE];
    bbAllAttacks[BLACK]     = bbPawnTakes[BLACK];
    bbMinorCoorAttacks[WHITE]  = 0ULL;
@@ -72,38 +70,51 @@ void sEvaluator::InitDynamicScore(sPosition *p)
 
 void sEvaluator::SetScaleFactor(sPosition *p) 
 {
-   mgFact = Min( p->phase, 24); // normalize for opening material
+   mgFact = Min( matEntry->phase, 24); // normalize for opening material
    egFact = 24 - mgFact;
 }
 
-// Interpolate between mgScore and egScore, depending on remaining material 
+// Interpolate between midgame and endgame score, depending on remaining material 
 int sEvaluator::Interpolate(void) {
-   return ( (mgFact * mgScore ) / 24 ) + ( (egFact * egScore ) / 24 );
+   return ( (mgFact * MgScore(phasedScore) ) / 24 ) + ( (egFact * EgScore(phasedScore) ) / 24 );
 }
 
-void sEvaluator::ScoreHanging(sPosition *p, int side)
+// Hanging pieces and space of both sides, with the bitboards of both
+// colors handled together (see bitboard/bbpair.h)
+
+void sEvaluator::ScoreHanging(sPosition *p)
 {
    int pc, sq, val;
-
-   U64 bbHanging    = p->bbCl[Opp(side)] & ~bbPawnTakes[Opp(side)]; 
-   U64 bbThreatened = p->bbCl[Opp(side)] & bbPawnTakes[side];
-   bbHanging |= bbThreatened;            // piece attacked by our pawn isn't well defended
-   bbHanging &= bbAllAttacks[side];      // obviously, hanging piece has to be attacked
-   bbHanging &= ~bbPc(p, Opp(side), P);  // currently we don't evaluate threats against pawns
-
-   U64 bbSpace = UnoccBb(p) & bbAllAttacks[side];
-   bbSpace &= ~bbRelRank[side][RANK_1];    // controlling home ground is not space advantage
-   bbSpace &= ~bbRelRank[side][RANK_2];
-   bbSpace &= ~bbRelRank[side][RANK_3];
-   bbSpace &= ~bbPawnTakes[Opp(side)]; // squares attacked by enemy pawns aren't effectively controlled
-   AddMisc(side, PopCnt(bbSpace), 0);
-
-   while (bbHanging) {
-      sq  = FirstOne(bbHanging);
-      pc  = TpOnSq(p, sq);
-      val = Data.matValue[pc] / 64;
-      AddMisc(side, 10+val, 18+val);
-      bbHanging &= bbHanging - 1;
+   U64 bbHanging[2], bbSpace[2];
+   const sBbPair bbHomeGround = PairMake(bbRANK_1 | bbRANK_2 | bbRANK_3, bbRANK_8 | bbRANK_7 | bbRANK_6);
+
+   sBbPair bbEnemy      = PairSwap(PairLoad(p->bbCl));
+   sBbPair bbEnemyPawns = PairMake(bbPc(p, BLACK, P), bbPc(p, WHITE, P));
+   sBbPair bbTakes      = PairLoad(bbPawnTakes);
+   sBbPair bbEnemyTakes = PairSwap(bbTakes);
+   sBbPair bbAttacks    = PairLoad(bbAllAttacks);
+
+   sBbPair bbHang = PairAndNot(bbEnemy, bbEnemyTakes);
+   bbHang = PairOr(bbHang, PairAnd(bbEnemy, bbTakes)); // piece attacked by our pawn isn't well defended
+   bbHang = PairAnd(bbHang, bbAttacks);                 // obviously, hanging piece has to be attacked
+   bbHang = PairAndNot(bbHang, bbEnemyPawns);           // currently we don't evaluate threats against pawns
+   PairStore(bbHanging, bbHang);
+
+   sBbPair bbSpc = PairAndNot(bbAttacks, PairBroadcast(OccBb(p)));
+   bbSpc = PairAndNot(bbSpc, bbHomeGround);  // controlling home ground is not space advantage
+   bbSpc = PairAndNot(bbSpc, bbEnemyTakes);  // squares attacked by enemy pawns aren't effectively controlled
+   PairStore(bbSpace, bbSpc);
+
+   for (int side = WHITE; side <= BLACK; side++) {
+      AddMisc(side, PopCnt(bbSpace[side]), 0);
+
+      while (bbHanging[side]) {
+         sq  = FirstOne(bbHanging[side]);
+         pc  = TpOnSq(p, sq);
+         val = Data.matValue[pc] / 64;
+         AddMisc(side, 10+val, 18+val);
+         bbHanging[side] &= bbHanging[side] - 1;
+      }
    }
 }
 
@@ -135,7 +146,7 @@ void sEvaluator::ScoreKingShield(sPosition *p, int side)
   bbNextFile = ShiftWest(bbKingFile);
   if (bbNextFile) result += EvalKingFile(p, side, bbNextFile);
 
-  mgScore += result * sideMult[side]; // add shield score to midgame score
+  phasedScore += MakeScore(result * sideMult[side], 0); // add shield score to midgame score
 }
 
 int sEvaluator::EvalKingFile(sPosition * p, int side, U64 bbFile)
@@ -191,16 +202,17 @@ void sEvaluator::ScorePatterns(sPosition *p, int side)
 
 int sEvaluator::ReturnFull(sPosition *p, int alpha, int beta)
 {
-#ifdef HASH_EVAL
-   int addr = p->hashKey % EVAL_HASH_SIZE;
-   if (EvalTT[addr].key == p->hashKey) {
-      int hashScore = EvalTT[addr].score;
-      return p->side == WHITE ? hashScore : -hashScore;
-   }
-#endif
+  int hashScore, estimate;
+
+  // eval cache: exact score can be reused at once, lazy one only
+  // if the new window would lead to the same lazy cutoff
+  if (EvalTable.Probe(p->hashKey, &hashScore, &estimate, &isExact)
+  && (isExact || estimate <= alpha - Data.lazyMargin || estimate >= beta + Data.lazyMargin))
+     return p->side == WHITE ? hashScore : -hashScore;
 
   int fullEval = 0;
-  int score = GetMaterialScore(p) + CheckmateHelper(p);
+  matEntry = ProbeMaterial(p);
+  int score = matEntry->score + CheckmateHelper(p);
   p->side == WHITE ? score+=5 : score-=5;
 
   InitStaticScore();
@@ -211,8 +223,7 @@ int sEvaluator::ReturnFull(sPosition *p, int alpha, int beta)
   score += (EvalTrappedBishop(p,WHITE) - EvalTrappedBishop(p,BLACK) );                 
   score += (EvalTrappedRook(p,WHITE)   - EvalTrappedRook(p,BLACK) );  
 
-  mgScore += (p->pstMg[WHITE] - p->pstMg[BLACK]);
-  egScore += (p->pstEg[WHITE] - p->pstEg[BLACK]);
+  phasedScore += (p->pst[WHITE] - p->pst[BLACK]);
   
 #ifdef LAZY_EVAL
   int tempScore = score + Interpolate();
@@ -240,28 +251,22 @@ int sEvaluator::ReturnFull(sPosition *p, int alpha, int beta)
 	  ScoreKingAttacks(p, BLACK);
 	  bbAllAttacks[WHITE] |= bbKingAttacks[KingSq(p, WHITE) ];
 	  bbAllAttacks[BLACK] |= bbKingAttacks[KingSq(p, BLACK) ];
-	  ScoreHanging(p, WHITE);
-	  ScoreHanging(p, BLACK);
+	  ScoreHanging(p);
 
 	  // ADDITIONAL PAWN EVAL
-	  ScoreP(p, WHITE);
-	  ScoreP(p, BLACK);
+	  ScoreP(p);
 
 	  // PATTERNS
 	  ScorePatterns(p, WHITE);
 	  ScorePatterns(p, BLACK);
       
 	  // ASYMMETRIC MOBILITY SCALING
-	  ScaleValue(&mgMobility[WHITE], Data.mobSidePercentage[WHITE]);
-	  ScaleValue(&mgMobility[BLACK], Data.mobSidePercentage[BLACK]);
-  	  ScaleValue(&egMobility[WHITE], Data.mobSidePercentage[WHITE]);
-	  ScaleValue(&egMobility[BLACK], Data.mobSidePercentage[BLACK]);
+	  ScaleValue(&mobility[WHITE], Data.mobSidePercentage[WHITE]);
+	  ScaleValue(&mobility[BLACK], Data.mobSidePercentage[BLACK]);
 
 	  // MERGING SCORE
-	  mgScore += ( mgMobility[WHITE] - mgMobility[BLACK] );
-	  egScore += ( egMobility[WHITE] - egMobility[BLACK] );
-	  mgScore += ( mgMisc[WHITE]     - mgMisc[BLACK]     );
-	  egScore += ( egMisc[WHITE]     - egMisc[BLACK]     );
+	  phasedScore += ( mobility[WHITE] - mobility[BLACK] );
+	  phasedScore += ( misc[WHITE]     - misc[BLACK]     );
 	  score   += Interpolate();    // merge middlegame and endgame scores
 	  score   += ( attScore[WHITE]  - attScore[BLACK] );
 #ifdef LAZY_EVAL
@@ -271,12 +276,12 @@ int sEvaluator::ReturnFull(sPosition *p, int alpha, int beta)
 
   score = PullToDraw(p, score);    // decrease score in drawish endgames
   score = FinalizeScore(p, score); // bounds, granulatity and weakening
+  isExact = fullEval;
 
-#ifdef HASH_EVAL
-   if (fullEval) {
-      EvalTT[addr].key = p->hashKey;
-      EvalTT[addr].score = score;
-   }
+#ifdef LAZY_EVAL
+  EvalTable.Store(p->hashKey, score, tempScore, fullEval);
+#else
+  EvalTable.Store(p->hashKey, score, 0, 1);
 #endif
 
   // return score relative to the side to move
@@ -286,15 +291,15 @@ int sEvaluator::ReturnFull(sPosition *p, int alpha, int beta)
 // fast evaluation function (material, pst, pawn structure)
 int sEvaluator::ReturnFast(sPosition *p)
 {
-  int score = GetMaterialScore(p) + CheckmateHelper(p);
+  matEntry = ProbeMaterial(p);
+  int score = matEntry->score + CheckmateHelper(p);
   p->side == WHITE ? score+=5 : score-=5;
 
   InitStaticScore();
   SetScaleFactor(p);
   EvalPawns(p);
 
-  mgScore += (p->pstMg[WHITE] - p->pstMg[BLACK]);
-  egScore += (p->pstEg[WHITE] - p->pstEg[BLACK]);
+  phasedScore += (p->pst[WHITE] - p->pst[BLACK]);
   
   score += Interpolate();
   score = PullToDraw(p, score);    // decrease score in drawish endgames
@@ -324,6 +329,5 @@ int sEvaluator::FinalizeScore(sPosition * p, int score)
 
 void sEvaluator::ScaleValue(int * value, int factor) 
 {
-   *value *= factor;
-   *value /= 100;
+   *value = MakeScore( ( MgScore(*value) * factor ) / 100, ( EgScore(*value) * factor ) / 100 );
 }
@@ -20,36 +20,45 @@
 #pragma once
 
 #define LAZY_EVAL
-//#define HASH_EVAL
 #define GRAIN_SIZE 4
 
+// Everything that depends only on pawn placement is calculated once per
+// pawn structure and kept in the pawn hash table of the thread.
+
 struct sPawnHashEntry {
   U64 pawnKey;
-  int mgPawns;
-  int egPawns;
-  int mgPassers;
-  int egPassers;
+  U64 bbPassers[2];      // passed pawns
+  U64 bbPawnTakes[2];    // squares attacked by pawns
+  U64 bbPawnCanTake[2];  // squares that pawns can attack as they advance
+  int pawns;             // pawn structure score, white minus black (packed midgame/endgame)
+  int passers;           // passed pawn score, white minus black (packed)
+  int misc[2];           // pawn-only parts of ScoreP(), added to miscellaneous scores (packed)
 };
 
-struct sEvalHashEntry {
-  U64 key;
-  int score;
-};
+// Everything that depends only on the numbers of pieces is looked up by
+// the material key: imbalance score, game phase, endgame scaling of both
+// sides and the draw recognizer to be used by the search.
+
+#define MAT_HASH_SIZE 8192 // entries, must be a power of two
+#define SCALE_PROBE   255  // scaling depends on piece placement, see SetDegradationFactor()
 
-#define PAWN_HASH_SIZE  512 * 512
-#define EVAL_HASH_SIZE  512 * 512
+enum eDrawCode { DRAW_NONE, DRAW_BARE, DRAW_MINORS, DRAW_KPK_WHITE, DRAW_KPK_BLACK };
+
+struct sMaterialEntry {
+  U64 matKey;
+  short score;           // material and imbalance, white minus black
+  short phase;
+  U8 scale[2];           // degradation factor (0..64) if that side is stronger, or SCALE_PROBE
+  U8 drawCode;           // eDrawCode
+};
 
 struct sEvaluator {
 private:
   int attScore[2];         // king attack scores
-  int mgMobility[2];       // midgame mobility scores
-  int egMobility[2];       // endgame mobility scores
-  int mgMisc[2];           // miscelanneous midgame scores
-  int egMisc[2];           // miscelanneous endgame scores
-  int pawnScoreMg[2];      // midgame pawn structure scores
-  int pawnScoreEg[2];      // endgame pawn structure scores
-  int passerScoreMg[2];    // midgame passed pawn scores
-  int passerScoreEg[2];    // endgame passed pawn scores 
+  int mobility[2];         // mobility scores (packed midgame/endgame, see MakeScore)
+  int misc[2];             // miscelanneous scores (packed)
+  int pawnScore[2];        // pawn structure scores (packed)
+  int passerScore[2];      // passed pawn scores (packed)
   U64 bbPawnTakes[2];    // squares controlled by pawns, used in mobility eval (pawn eval uses only occupancy masks)
   U64 bbPawnCanTake[2]; // squares that can be controlled by pawns as they advance, used in outpost eval
   U64 bbDiagChecks[2];
@@ -63,14 +72,18 @@ private:
   int attWood[2];
   int attNumber[2];        // no. of pieces participating in the attack
   int mgFact,  egFact;     // material-driven scaling factors
-  int mgScore, egScore;    // partial midgame and endgame scores (to be scaled)
+  int phasedScore;         // partial midgame and endgame scores, packed (to be scaled)
 
-  sPawnHashEntry PawnTT[PAWN_HASH_SIZE]; // pawn transposition table
-#ifdef HASH_EVAL
-  sEvalHashEntry EvalTT[EVAL_HASH_SIZE]; // eval transposition table
-#endif
+  sPawnHashEntry *PawnTT;     // pawn transposition table
+  U64 pawnTtSize;             // number of entries
+  int pawnTtMb;               // size in megabytes, as requested
+  sPawnHashEntry *pawnEntry;  // entry of the position being evaluated
+  sMaterialEntry MatTT[MAT_HASH_SIZE]; // material table
+  sMaterialEntry *matEntry;   // entry of the position being evaluated
   
   int GetMaterialScore(sPosition *p);
+  int MaterialScale(sPosition *p, int stronger);
+  int MaterialDrawCode(sPosition *p);
   void AddMobility(int pc, int side, int cnt);
   void AddMisc(int side, int mg, int eg);
   void AddKingAttack(int side, int pc, int cnt);
@@ -83,18 +96,19 @@ private:
   int SetDegradationFactor(sPosition *p, int stronger);
   int Interpolate(void);
   void SinglePawnScore(sPosition *p, int side); // eval_pawns.c
+  void InitPawnEntry(sPosition *p, int side);   // eval_pawns.c
   void EvalPawnCenter(sPosition *p, int side);  // eval_pawns.c
   void EvalPawns(sPosition *p);				    // eval_pawns.c
   void ScoreN(sPosition *p, int side);
   void ScoreB(sPosition *p, int side);
   void ScoreR(sPosition *p, int side);
   void ScoreQ(sPosition *p, int side);
-  void ScoreP(sPosition *p, int side);
+  void ScoreP(sPosition *p);                   // both sides at once
   void ScorePatterns(sPosition *p, int side);
   void ScoreKingShield(sPosition *p, int side);
   void ScoreKingAttacks(sPosition *p, int side);
   void ScoreRelationToPawns(sPosition *p, int side, int piece, int sq);
-  void ScoreHanging(sPosition *p, int side);
+  void ScoreHanging(sPosition *p);             // both sides at once
   int  EvalKingFile(sPosition * p, int side, U64 bbFile);
   int  EvalFileShelter(U64 bbOwnPawns, int side);
   int  EvalFileStorm(U64 bbOppPawns, int side);
@@ -104,13 +118,19 @@ private:
   int  PullToDraw(sPosition *p, int score);
   int  FinalizeScore(sPosition *p, int score);
 public:
+  int isExact;             // was the last ReturnFull() score calculated without lazy cutoff?
   int Normalize(int val, int limit);
-  void ScaleValue(int * value, int factor);
+  void ScaleValue(int * value, int factor); // scales both parts of a packed score
   int ReturnFast(sPosition *p);
   int ReturnFull(sPosition *p, int alpha, int beta);
+  void AllocPawnTable(int mbsize);    // eval_pawns.c
+  void PrefetchPawnEntry(U64 pawnKey); // eval_pawns.c
+  U64 PawnTableSize(void) { return pawnTtSize; }
+  void ClearMaterialTable(void);       // eval_material.c
+  sMaterialEntry *ProbeMaterial(sPosition *p); // eval_material.c
 };
 
-extern struct sEvaluator Eval;
+extern THREAD_LOCAL struct sEvaluator Eval;
 
 int NotOnBishColor(sPosition * p, int bishSide, int sq);
 int BishopsAreDifferent(sPosition * p);
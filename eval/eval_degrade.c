@@ -28,8 +28,12 @@ static const U64 bbNormalPawn[2] = { bbRANK_2 | bbRANK_3 | bbRANK_4 | bbRANK_5,
 int sEvaluator::PullToDraw(sPosition *p, int score)
 {
   int degradation = 64; 
-  if (score > 0) degradation = SetDegradationFactor(p, WHITE);
-  if (score < 0) degradation = SetDegradationFactor(p, BLACK);
+  int stronger = (score > 0) ? WHITE : BLACK;
+
+  if (score != 0) {
+     degradation = matEntry->scale[stronger];
+     if (degradation == SCALE_PROBE) degradation = SetDegradationFactor(p, stronger);
+  }
 
   score *= degradation;
   return score / 64;
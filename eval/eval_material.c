@@ -17,6 +17,7 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <string.h>
 #include "../rodent.h"
 #include "../data.h"
 #include "../bitboard/bitboard.h"
@@ -111,6 +112,70 @@ int sEvaluator::GetMaterialScore(sPosition *p)
    return score + imbalance[majorIndex][minorIndex];
 }
 
+// Scaling that can be told from material alone follows the order of tests
+// in SetDegradationFactor(); anything else is left to that function.
+
+int sEvaluator::MaterialScale(sPosition *p, int stronger)
+{
+   int weaker = Opp(stronger);
+
+   if ( p->pieceMat[stronger] > 1400
+   ||   p->pieceMat[weaker] > 1400 ) return 64;
+
+   // whether bishops are on opposite colors is a board test, made before
+   // anything else in SetDegradationFactor(), so it is left to that function
+   if ( PcMatBishop(p, stronger) && PcMatBishop(p, weaker) ) return SCALE_PROBE;
+
+   if ( p->pcCount[stronger][P] > 2 || p->pcCount[weaker][P] > 2 ) return 64;
+
+   // single minor piece without pawns cannot win
+   if ( p->pcCount[stronger][P] == 0
+   &&   p->pieceMat[stronger] < 400 ) return 0;
+
+   return SCALE_PROBE;
+}
+
+// draw recognizers of sSearcher::RecognizeDraw() that apply to this material
+
+int sEvaluator::MaterialDrawCode(sPosition *p)
+{
+   if (p->pcCount[WHITE][P] == 0 && p->pcCount[BLACK][P] == 0) {
+      if ( p->pieceMat[WHITE] + p->pieceMat[BLACK] < 400 ) return DRAW_BARE;
+      if ( p->pieceMat[WHITE] < 400 && p->pieceMat[BLACK] < 400 ) return DRAW_MINORS;
+   }
+
+   if (p->pieceMat[WHITE] == 0 && p->pieceMat[BLACK] == 0) {
+      if (p->pcCount[WHITE][P] == 1 && p->pcCount[BLACK][P] == 0) return DRAW_KPK_WHITE;
+      if (p->pcCount[BLACK][P] == 1 && p->pcCount[WHITE][P] == 0) return DRAW_KPK_BLACK;
+   }
+
+   return DRAW_NONE;
+}
+
+// Material values may change with options, so the table is cleared
+// at the beginning of every search.
+
+void sEvaluator::ClearMaterialTable(void)
+{
+   memset(MatTT, 0, sizeof(MatTT));
+}
+
+sMaterialEntry *sEvaluator::ProbeMaterial(sPosition *p)
+{
+   sMaterialEntry *entry = MatTT + (p->matKey & (MAT_HASH_SIZE - 1));
+
+   if (entry->matKey != p->matKey) {
+      entry->matKey       = p->matKey;
+      entry->score        = GetMaterialScore(p);
+      entry->phase        = p->phase;
+      entry->scale[WHITE] = MaterialScale(p, WHITE);
+      entry->scale[BLACK] = MaterialScale(p, BLACK);
+      entry->drawCode     = MaterialDrawCode(p);
+   }
+
+   return entry;
+}
+
 int sEvaluator::CheckmateHelper(sPosition *p) 
 {
    int result = 0;
@@ -126,7 +191,7 @@ int sEvaluator::CheckmateHelper(sPosition *p)
       && p->pieceMat[BLACK] < 600) 
       {
          // drive enemy king towards the edge
-         result += (40 - Data.pstEg[BLACK][K][p->kingSquare[BLACK]] + Data.distance[p->kingSquare[WHITE]] [p->kingSquare[BLACK]]);
+         result += (40 - EgScore(Data.pst[BLACK][K][p->kingSquare[BLACK]]) + Data.distance[p->kingSquare[WHITE]] [p->kingSquare[BLACK]]);
 
          if (MaterialBN(p, WHITE) ) { // mate with bishop and knight
             if ( bbPc(p, WHITE, B) & bbWhiteSq) result -= 2*BN_bb[p->kingSquare[BLACK]];
@@ -138,7 +203,7 @@ int sEvaluator::CheckmateHelper(sPosition *p)
       && p->pieceMat[WHITE] < 600)
 	  {
          // drive enemy king towards the edge
-         result -= (40 - Data.pstEg[WHITE][K][p->kingSquare[WHITE]] + Data.distance[p->kingSquare[WHITE]] [p->kingSquare[BLACK]]);
+         result -= (40 - EgScore(Data.pst[WHITE][K][p->kingSquare[WHITE]]) + Data.distance[p->kingSquare[WHITE]] [p->kingSquare[BLACK]]);
 
          if (MaterialBN(p, BLACK) ) { // mate with bishop and knight
             if ( bbPc(p, BLACK, B) & bbWhiteSq) result += 2*BN_bb[p->kingSquare[WHITE]];
@@ -18,45 +18,131 @@
 */
 
 #include "../bitboard/bitboard.h"
+#include "../bitboard/bbpair.h"
 #include "../data.h"
 #include "../rodent.h"
+#include "../trans.h"
 #include "eval.h"
+#include <stdio.h>
+#include <stdlib.h>
 
 const int centDefense = 5;
-const int doubledPawn [2] [8]= { {-25, -25, -25, -25, -25, -25, -25, -25 }, {-15, -17, -19, -19, -19, -19, -17, -15 } };
+const int doubledPawn [8] = { MakeScore(-25, -15), MakeScore(-25, -17), MakeScore(-25, -19), MakeScore(-25, -19),
+                              MakeScore(-25, -19), MakeScore(-25, -19), MakeScore(-25, -17), MakeScore(-25, -15) };
 const int pawnIsolatedOnOpen = -15;
 const int pawnBackwardOnOpen = -15;
 
-void sEvaluator::EvalPawns(sPosition *p)
+// Each thread has its own pawn hash table. Its size is set by the "PawnHash"
+// option and checked at the beginning of every search.
+
+void sEvaluator::AllocPawnTable(int mbsize)
 {
-   int pawnHash = p->pawnKey % PAWN_HASH_SIZE;
-
-   // try reading score from pawn hashtable
-   if ( PawnTT[pawnHash].pawnKey == p->pawnKey) {
-      mgScore += PawnTT[pawnHash].mgPawns;
-      egScore += PawnTT[pawnHash].egPawns;
-      mgScore += PawnTT[pawnHash].mgPassers;
-      egScore += PawnTT[pawnHash].egPassers;
+   if (PawnTT && mbsize == pawnTtMb) return;
+
+   free(PawnTT);
+   pawnTtMb   = mbsize;
+   pawnTtSize = ((U64)Max(mbsize, 1) << 20) / sizeof(sPawnHashEntry);
+   PawnTT = (sPawnHashEntry *) calloc((size_t)pawnTtSize, sizeof(sPawnHashEntry));
+   if (!PawnTT) {
+      printf("info string could not allocate pawn hash table\n");
+      exit(1);
    }
-   else
-   {
+}
+
+// called by DoMove() when the pawn key changes, so that the entry is in cache by the time eval needs it
+
+void sEvaluator::PrefetchPawnEntry(U64 pawnKey)
+{
+#if defined(USE_TT_SSE2)
+   _mm_prefetch((const char *)(PawnTT + TtBucketIndex(pawnKey, pawnTtSize)), _MM_HINT_T0);
+#elif defined(__GNUC__)
+   __builtin_prefetch(PawnTT + TtBucketIndex(pawnKey, pawnTtSize));
+#endif
+}
+
+void sEvaluator::EvalPawns(sPosition *p)
+{
+   pawnEntry = PawnTT + TtBucketIndex(p->pawnKey, pawnTtSize);
+
+   // on a pawn hash miss, calculate everything that depends only on pawns
+   if ( pawnEntry->pawnKey != p->pawnKey) {
       SinglePawnScore(p, WHITE);
       SinglePawnScore(p, BLACK);
       EvalPawnCenter(p, WHITE);
       EvalPawnCenter(p, BLACK);
- 
-      mgScore += ( ( (pawnScoreMg[WHITE] - pawnScoreMg[BLACK]) * Data.pawnStruct ) / 100 );
-      egScore += ( ( (pawnScoreEg[WHITE] - pawnScoreEg[BLACK]) * Data.pawnStruct ) / 100 );
-      mgScore += ( ( (passerScoreMg[WHITE] - passerScoreMg[BLACK]) * Data.passedPawns ) / 100 );
-      egScore += ( ( (passerScoreEg[WHITE] - passerScoreEg[BLACK]) * Data.passedPawns ) / 100 );
-
-      // save score to pawn hashtable
-      PawnTT[pawnHash].pawnKey = p->pawnKey;
-      PawnTT[pawnHash].mgPawns   = ( ( (pawnScoreMg[WHITE] - pawnScoreMg[BLACK])* Data.pawnStruct ) / 100 );
-      PawnTT[pawnHash].egPawns   = ( ( (pawnScoreEg[WHITE] - pawnScoreEg[BLACK])* Data.pawnStruct ) / 100 );
-      PawnTT[pawnHash].mgPassers = ( ( (passerScoreMg[WHITE] - passerScoreMg[BLACK])* Data.passedPawns ) / 100 );
-      PawnTT[pawnHash].egPassers = ( ( (passerScoreEg[WHITE] - passerScoreEg[BLACK])* Data.passedPawns ) / 100 );
+
+      // squares attacked by pawns now and as they advance, both colors at once
+#ifdef USE_ATTACK_MAPS
+      sBbPair bbTakes = PairLoad(p->bbPawnAtt);
+#else
+      sBbPair bbTakes = PairPawnAttacks(PairMake(bbPc(p, WHITE, P), bbPc(p, BLACK, P)));
+#endif
+      PairStore(pawnEntry->bbPawnTakes, bbTakes);
+      PairStore(pawnEntry->bbPawnCanTake, PairFillFwd(bbTakes));
+
+      InitPawnEntry(p, WHITE);
+      InitPawnEntry(p, BLACK);
+
+      pawnEntry->pawnKey = p->pawnKey;
+      pawnEntry->pawns   = pawnScore[WHITE] - pawnScore[BLACK];
+      pawnEntry->passers = passerScore[WHITE] - passerScore[BLACK];
+      ScaleValue(&pawnEntry->pawns, Data.pawnStruct);
+      ScaleValue(&pawnEntry->passers, Data.passedPawns);
    }
+
+   phasedScore += pawnEntry->pawns;
+   phasedScore += pawnEntry->passers;
+}
+
+// Passers and the pawn-only terms of ScoreP() for the pawn hash entry
+
+void sEvaluator::InitPawnEntry(sPosition *p, int side)
+{
+  const int oppo = Opp(side);
+  int sq, flagIsWeak;
+  U64 bbPieces = bbPc(p, side, P);
+  U64 bbStop, bbBack;
+
+  pawnEntry->bbPassers[side] = 0ULL;
+  pawnEntry->misc[side] = 0;
+
+  while (bbPieces) {
+    sq = PopFirstBit(&bbPieces);
+	bbStop = ShiftFwd(SqBb(sq), side);
+	bbBack = SqBb(sq) ^ ShiftFwd(SqBb(sq), oppo);
+	flagIsWeak = ( ( bbPawnSupport[side][sq] & bbPc(p,side, P) ) == 0);
+
+	if ( !flagIsWeak                                     // technically speaking, this pawn is not weak, 
+	&&   !(bbBack & pawnEntry->bbPawnTakes[side]) ) {    // but it has lost contact  with the pawn mass,
+	   pawnEntry->misc[side] += MakeScore(-4, -8);       // so it is at least slightly vulnerable.
+	}
+
+	// hidden passer
+	if (bbStop & bbPc(p, oppo,P)
+	&& SqBb(sq) & bbRelRank[side][RANK_6] 
+	&& (pawnEntry->bbPawnTakes[side] & sq) ) {
+       int flagHiddenPasser = 0;
+
+	   U64 bbDefender = ShiftWest(bbBack);
+	   if ( bbDefender && bbPc(p, side, P) ) {
+	      if ( !(ShiftFwd(SqBb(bbDefender), side) & bbPc(p, oppo, P) ) 
+	      && ( !(ShiftWest(ShiftWest(bbStop)) & bbPc(p, oppo, P) ) )
+	      ) flagHiddenPasser = 1;
+	   }
+	    
+	   bbDefender = ShiftEast(bbBack);
+	   if ( bbDefender && bbPc(p, side, P) ) {
+	      if ( !(ShiftFwd(SqBb(bbDefender), side) & bbPc(p, oppo, P) ) 
+          && ( !(ShiftEast(ShiftEast(bbStop)) & bbPc(p, oppo, P) ) ) )
+	      flagHiddenPasser = 1;
+	   }
+
+	   if (flagHiddenPasser) pawnEntry->misc[side] += MakeScore(0, 40);
+	}
+
+	if (!(bbPassedMask[side][sq] & bbPc(p, oppo, P)))
+	   pawnEntry->bbPassers[side] |= SqBb(sq);
+  }
 }
 
 void sEvaluator::EvalPawnCenter(sPosition *p, int side)
@@ -64,12 +150,12 @@ void sEvaluator::EvalPawnCenter(sPosition *p, int side)
    int oppo = Opp(side);	  
    if (bbPc(p, side, P) & RelSqBb(D4,side) ) {
       // defend central pawns (pawns side by side evaluated as "phalanx")
-      if (bbPc(p, side, P) & RelSqBb(E3,side) )  pawnScoreMg[side] += centDefense;
-      if (bbPc(p, side, P) & RelSqBb(C3,side) )  pawnScoreMg[side] += centDefense;
+      if (bbPc(p, side, P) & RelSqBb(E3,side) )  pawnScore[side] += MakeScore(centDefense, 0);
+      if (bbPc(p, side, P) & RelSqBb(C3,side) )  pawnScore[side] += MakeScore(centDefense, 0);
    }
 
    if (bbPc(p, side, P) & RelSqBb(E4,side) ) {
-      if ( bbPc(p, side, P) & RelSqBb(D3,side) ) pawnScoreMg[side] += centDefense;
+      if ( bbPc(p, side, P) & RelSqBb(D3,side) ) pawnScore[side] += MakeScore(centDefense, 0);
    }
 }
 
@@ -92,15 +178,8 @@ void sEvaluator::SinglePawnScore(sPosition *p, int side)
 	flagPhalanx2  = ShiftWest(SqBb(sq) ) & bbOwnPawns;
 	flagIsWeak    = !( bbPawnSupport[side][sq] & bbOwnPawns );
 	
-	if (flagIsDoubled) {
-	    pawnScoreMg[side] += doubledPawn[MG][File(sq)];
-	    pawnScoreEg[side] += doubledPawn[EG][File(sq)];
-    }
-
-	if (flagIsPhalanx) {
-		pawnScoreMg[side] += Data.pawnProperty[PHALANX][MG][side][sq];
-		//pawnScoreEg[side] += Data.phalanxEg[side][sq];
-	}
+	if (flagIsDoubled) pawnScore[side] += doubledPawn[File(sq)];
+	if (flagIsPhalanx) pawnScore[side] += Data.pawnProperty[PHALANX][side][sq];
 
 	if (flagIsOpen) {
 		U64 bbObstacles = bbPassedMask[side][sq] & bbPc(p, oppo, P);
@@ -120,10 +199,10 @@ void sEvaluator::SinglePawnScore(sPosition *p, int side)
 	if (flagIsWeak) {
 		if (!(bbAdjacentMask[File(sq)] & bbOwnPawns)) { // isolated 
 		   AddPawnProperty(ISOLATED,side,sq);
-		   if (flagIsOpen) pawnScoreMg[side] += pawnIsolatedOnOpen;
+		   if (flagIsOpen) pawnScore[side] += MakeScore(pawnIsolatedOnOpen, 0);
 		} else {                                        // backward
 		   AddPawnProperty(BACKWARD,side,sq);
-		   if (flagIsOpen) pawnScoreMg[side] += pawnBackwardOnOpen;
+		   if (flagIsOpen) pawnScore[side] += MakeScore(pawnBackwardOnOpen, 0);
 		}
 	}
   }
@@ -131,12 +210,10 @@ void sEvaluator::SinglePawnScore(sPosition *p, int side)
 
 void sEvaluator::AddPawnProperty(int pawnProperty, int side, int sq)
 {
-   pawnScoreMg[side] += Data.pawnProperty[pawnProperty][MG][side][sq]; 
-   pawnScoreEg[side] += Data.pawnProperty[pawnProperty][EG][side][sq];
+   pawnScore[side] += Data.pawnProperty[pawnProperty][side][sq];
 }
 
 void sEvaluator::AddPasserScore(int pawnProperty, int side, int sq)
 {
-   passerScoreMg[side] += Data.pawnProperty[pawnProperty][MG][side][sq]; 
-   passerScoreEg[side] += Data.pawnProperty[pawnProperty][EG][side][sq];
+   passerScore[side] += Data.pawnProperty[pawnProperty][side][sq];
 }
@@ -22,6 +22,7 @@
 
 #include "../rodent.h"
 #include "../bitboard/bitboard.h"
+#include "../bitboard/bbpair.h"
 #include "../data.h"
 #include "../bitboard/gencache.h"
 #include "eval.h"
@@ -195,7 +196,7 @@ void sEvaluator::ScoreR(sPosition *p, int side)
 	    while (bbContact) {
            contactSq = PopFirstBit(&bbContact);
 
-	       if ( Swap(p, sq, contactSq) >= 0 ) {
+	       if ( SeeGe(p, SetMove(NORMAL, sq, contactSq), 0) ) {
 			  checkCount[side] += rookContactCheck[Data.safetyStyle]; 
 		      break;
 	       }
@@ -230,7 +231,11 @@ void sEvaluator::ScoreQ(sPosition *p, int side)
 
   while (bbPieces) {
     sq = PopFirstBit(&bbPieces);             // set piece location and clear it from bbPieces 
+#ifdef USE_ATTACK_MAPS
+	bbMob = p->bbAttFrom[sq];                // queen sees the real occupancy, as in attack maps
+#else
 	bbMob = GenCache.GetQueenMob(bbOcc, sq); // set control/mobility bitboard
+#endif
 	bbAllAttacks[side] |= bbMob;             // update attack data
 
 	// attacks on enemy pieces
@@ -255,7 +260,7 @@ void sEvaluator::ScoreQ(sPosition *p, int side)
 	    while (bbContact) {
            contactSq = PopFirstBit(&bbContact);
 
-	       if ( Swap(p, sq, contactSq) >= 0 ) {
+	       if ( SeeGe(p, SetMove(NORMAL, sq, contactSq), 0) ) {
 			  checkCount[side] += queenContactCheck[Data.safetyStyle]; 
 		      break;
 	       }
@@ -282,73 +287,61 @@ void sEvaluator::ScoreQ(sPosition *p, int side)
   }
 }
 
-void sEvaluator::ScoreP(sPosition *p, int side) 
-{
-  const int oppo = Opp(side);
-  int sq, passUnitMg, passUnitEg, flagIsWeak;
-  U64 bbPieces = bbPc(p, side, P);
-  U64 bbOcc = OccBb(p);
-  U64 bbStop, bbBack, bbObstacles;
-  
-  while (bbPieces) {
-    sq = PopFirstBit(&bbPieces);
-	bbStop = ShiftFwd(SqBb(sq), side);
-	bbBack = SqBb(sq) ^ ShiftFwd(SqBb(sq), oppo);
-	flagIsWeak = ( ( bbPawnSupport[side][sq] & bbPc(p,side, P) ) == 0);
-
-	if ( !flagIsWeak                       // technically speaking, this pawn is not weak, 
-	&&   !(bbBack & bbPawnTakes[side]) )   // but it has lost contact  with the pawn mass,
-	AddMisc(side,-4,-8);                   // so it is at least slightly vulnerable.
-	
-	if (bbStop &~bbOcc) {                  // this pawn is mobile
-	   if (Data.pstMg[side][P][sq] > 0)    // bonus gets bigger for well positioned pawns
-		   AddMisc(side, 5, 2);
-	   else AddMisc(side, 2, 1);
-	}
+// Pawn terms of both sides. Masks of mobile pawns and of stop squares
+// of passers are made for both colors at once (see bitboard/bbpair.h),
+// so that the loops below only test single bits.
 
-	// hidden passer
-	if (bbStop & bbPc(p, oppo,P)
-	&& SqBb(sq) & bbRelRank[side][RANK_6] 
-	&& (bbPawnTakes[side] & sq) ) {
-       int flagHiddenPasser = 0;
-
-	   U64 bbDefender = ShiftWest(bbBack);
-	   if ( bbDefender && bbPc(p, side, P) ) {
-	      if ( !(ShiftFwd(SqBb(bbDefender), side) & bbPc(p, oppo, P) ) 
-	      && ( !(ShiftWest(ShiftWest(bbStop)) & bbPc(p, oppo, P) ) )
-	      ) flagHiddenPasser = 1;
-	   }
-	    
-	   bbDefender = ShiftEast(bbBack);
-	   if ( bbDefender && bbPc(p, side, P) ) {
-	      if ( !(ShiftFwd(SqBb(bbDefender), side) & bbPc(p, oppo, P) ) 
-          && ( !(ShiftEast(ShiftEast(bbStop)) & bbPc(p, oppo, P) ) ) )
-	      flagHiddenPasser = 1;
-	   }
-
-	   if (flagHiddenPasser) AddMisc(side, 0, 40);
-	}
-	   
-	bbObstacles = bbPassedMask[side][sq] & bbPc(p, oppo, P);
-
-	// additional evaluation of a passed pawn 
-	if (!bbObstacles) {
-		passUnitMg = ( Data.pawnProperty[PASSED][MG][side][sq] * Data.passedPawns ) / 500;
-		passUnitEg = ( Data.pawnProperty[PASSED][EG][side][sq] * Data.passedPawns ) / 500;
-
-		// enemy king distance to a passer (failed to find good value for a friendly king)
-		AddMisc(side, 0, (-Data.distance[sq] [p->kingSquare[Opp(side)]] * passUnitEg) / 6);
-
-		// blocked and unblocked passers
-		if (bbStop &~bbOcc) AddMisc(side,  passUnitMg,  passUnitEg);
-		else                AddMisc(side, -passUnitMg, -passUnitEg);
-
-		// control of stop square
-		if (bbStop &~ bbAllAttacks[oppo] ) {
-           AddMisc(side,  passUnitMg,  passUnitEg);
-           if (bbStop & bbAllAttacks[side] ) AddMisc(side,  passUnitMg,  passUnitEg);
-		}
-	}
+void sEvaluator::ScoreP(sPosition *p) 
+{
+  int sq, passUnitMg, passUnitEg;
+  U64 bbMobile[2], bbFreeStop[2], bbSafeStop[2], bbHeldStop[2];
+  U64 bbStop;
+
+  sBbPair bbFree    = PairBroadcast(UnoccBb(p));
+  sBbPair bbPawns   = PairMake(bbPc(p, WHITE, P), bbPc(p, BLACK, P));
+  sBbPair bbStops   = PairFwd(PairLoad(pawnEntry->bbPassers));
+  sBbPair bbAttacks = PairLoad(bbAllAttacks);
+
+  PairStore(bbMobile,   PairAnd(bbPawns, PairSwap(PairFwd(bbFree)))); // pawns that can advance
+  PairStore(bbFreeStop, PairAnd(bbStops, bbFree));
+  PairStore(bbSafeStop, PairAndNot(bbStops, PairSwap(bbAttacks)));     // not controlled by enemy
+  PairStore(bbHeldStop, PairAnd(bbStops, bbAttacks));
+
+  for (int side = WHITE; side <= BLACK; side++) {
+
+    // weak and hidden passed pawns (see InitPawnEntry())
+    misc[side] += pawnEntry->misc[side];
+
+    // mobile pawns
+    U64 bbPieces = bbMobile[side];
+    while (bbPieces) {
+      sq = PopFirstBit(&bbPieces);
+	  if (MgScore(Data.pst[side][P][sq]) > 0)    // bonus gets bigger for well positioned pawns
+	     AddMisc(side, 5, 2);
+	  else AddMisc(side, 2, 1);
+    }
+
+    // additional evaluation of passed pawns
+    bbPieces = pawnEntry->bbPassers[side];
+    while (bbPieces) {
+      sq = PopFirstBit(&bbPieces);
+	  bbStop = ShiftFwd(SqBb(sq), side);
+	  passUnitMg = ( MgScore(Data.pawnProperty[PASSED][side][sq]) * Data.passedPawns ) / 500;
+	  passUnitEg = ( EgScore(Data.pawnProperty[PASSED][side][sq]) * Data.passedPawns ) / 500;
+
+	  // enemy king distance to a passer (failed to find good value for a friendly king)
+	  AddMisc(side, 0, (-Data.distance[sq] [p->kingSquare[Opp(side)]] * passUnitEg) / 6);
+
+	  // blocked and unblocked passers
+	  if (bbStop & bbFreeStop[side]) AddMisc(side,  passUnitMg,  passUnitEg);
+	  else                           AddMisc(side, -passUnitMg, -passUnitEg);
+
+	  // control of stop square
+	  if (bbStop & bbSafeStop[side]) {
+         AddMisc(side,  passUnitMg,  passUnitEg);
+         if (bbStop & bbHeldStop[side]) AddMisc(side,  passUnitMg,  passUnitEg);
+	  }
+    }
   }
 }
 
@@ -361,14 +354,12 @@ void sEvaluator::AddKingAttack(int side, int pc, int cnt)
 
 void sEvaluator::AddMobility( int pc, int side, int cnt)
 {
-   mgMobility[side] += Data.mobBonusMg [pc] [cnt];
-   egMobility[side] += Data.mobBonusEg [pc] [cnt];
+   mobility[side] += Data.mobBonus [pc] [cnt];
 }
 
 void sEvaluator::AddMisc(int side, int mg, int eg)
 {
-   mgMisc[side] += mg;
-   egMisc[side] += eg;
+   misc[side] += MakeScore(mg, eg);
 }
 
 void sEvaluator::ScoreRelationToPawns(sPosition *p, int side, int piece, int sq)
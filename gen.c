@@ -22,315 +22,464 @@
 #include "rodent.h"
 #include "bitboard/gencache.h"
 
-int *GenerateCaptures(sPosition *p, int *list)
+// Move generators are templates on the side to move, so that pawn
+// directions, promotion ranks and castling squares become constants.
+// The runtime side is read once per call, in the wrappers below them.
+// Pieces are serialized in the same order as before: white ones from
+// the 8th rank down, their targets from the 1st rank up, and vice versa.
+
+static FORCEINLINE int *AddPromotions(int *list, int from, int to)
 {
-  U64 bbPieces, bbMoves;
-  int side, from, to;
+  *list++ = SetMove(Q_PROM, from, to);
+  *list++ = SetMove(N_PROM, from, to);
+  *list++ = SetMove(R_PROM, from, to);
+  *list++ = SetMove(B_PROM, from, to);
+  return list;
+}
 
-  side = p->side;
-  U64 bbOpp = p->bbCl[Opp(side)];
+template <int side>
+static int *GenerateCaptures(sPosition *p, int *list)
+{
+  const int up     = (side == WHITE) ? 8 : -8;  // square offsets of pawn moves
+  const int upWest = (side == WHITE) ? 7 : -9;
+  const int upEast = (side == WHITE) ? 9 : -7;
+  const U64 bbRank7 = (side == WHITE) ? bbRANK_7 : bbRANK_2;
 
-  if (side == WHITE) {
+  U64 bbPieces, bbMoves;
+  U64 bbOpp  = p->bbCl[Opp(side)];
+  U64 bbPawn = bbPc(p, side, P);
+  int from, to;
 
-    bbMoves = ((bbPc(p, WHITE, P) & bbNotA & bbRANK_7) << 7) & p->bbCl[BLACK];
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(Q_PROM, to-7, to);
-	  *list++ = SetMove(N_PROM, to-7, to);
-      *list++ = SetMove(R_PROM, to-7, to);
-      *list++ = SetMove(B_PROM, to-7, to);
-    }
+  // promotions, with and without capture
+  bbMoves = ShiftFwd<side>(ShiftWest(bbPawn & bbRank7)) & bbOpp;
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    list = AddPromotions(list, to - upWest, to);
+  }
 
-    bbMoves = ((bbPc(p, WHITE, P) & bbNotH & bbRANK_7) << 9) & p->bbCl[BLACK];
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(Q_PROM, to-9, to);
-	  *list++ = SetMove(N_PROM, to-9, to);
-      *list++ = SetMove(R_PROM, to-9, to);
-      *list++ = SetMove(B_PROM, to-9, to);
-    }
+  bbMoves = ShiftFwd<side>(ShiftEast(bbPawn & bbRank7)) & bbOpp;
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    list = AddPromotions(list, to - upEast, to);
+  }
 
-    bbMoves = ((bbPc(p, WHITE, P) & bbRANK_7) << 8) & UnoccBb(p);
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(Q_PROM, to-8, to);
-	  *list++ = SetMove(N_PROM, to-8, to);
-      *list++ = SetMove(R_PROM, to-8, to);
-      *list++ = SetMove(B_PROM, to-8, to);
-    }
+  bbMoves = ShiftFwd<side>(bbPawn & bbRank7) & UnoccBb(p);
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    list = AddPromotions(list, to - up, to);
+  }
 
-    bbMoves = ShiftNW(bbPc(p, WHITE, P) & ~bbRANK_7) & p->bbCl[BLACK];
-    while (bbMoves) {
-      to = PopFirstBit(&bbMoves);
-      *list++ = SetMove(NORMAL, to-7, to);
-    }
+  // pawn captures
+  bbMoves = ShiftFwd<side>(ShiftWest(bbPawn & ~bbRank7)) & bbOpp;
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    *list++ = SetMove(NORMAL, to - upWest, to);
+  }
 
-    bbMoves = ShiftNE(bbPc(p, WHITE, P) & ~bbRANK_7) & p->bbCl[BLACK];
-    while (bbMoves) {
-      to = PopFirstBit(&bbMoves);
-      *list++ = SetMove(NORMAL, to-9, to);
-    }
+  bbMoves = ShiftFwd<side>(ShiftEast(bbPawn & ~bbRank7)) & bbOpp;
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    *list++ = SetMove(NORMAL, to - upEast, to);
+  }
 
-	// en passant capture
-    if ((to = p->epSquare) != NO_SQ) {
-      if (((bbPc(p, WHITE, P) & bbNotA) << 7) & SqBb(to))
-        *list++ = SetMove(EP_CAP, to-7, to);
-      if (((bbPc(p, WHITE, P) & bbNotH) << 9) & SqBb(to))
-        *list++ = SetMove(EP_CAP, to-9, to);
-    }
+  // en passant capture
+  if ((to = p->epSquare) != NO_SQ) {
+    if (ShiftFwd<side>(ShiftWest(bbPawn)) & SqBb(to))
+      *list++ = SetMove(EP_CAP, to - upWest, to);
+    if (ShiftFwd<side>(ShiftEast(bbPawn)) & SqBb(to))
+      *list++ = SetMove(EP_CAP, to - upEast, to);
+  }
 
   bbPieces = bbPc(p, side, N);
   while (bbPieces) {
-    from = PopFlippedBit(&bbPieces);
+    from = PopNextBit<side>(&bbPieces);
     bbMoves = bbKnightAttacks[from] & bbOpp;
 
     while (bbMoves) {
-      to = PopFirstBit(&bbMoves);
+      to = PopNextBit<Opp(side)>(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
   bbPieces = bbPc(p, side, B);
   while (bbPieces) {
-    from = PopFlippedBit(&bbPieces);
+    from = PopNextBit<side>(&bbPieces);
 	bbMoves = GenCache.GetBishMob(OccBb(p), from) & bbOpp;
+
     while (bbMoves) {
-      to = PopFirstBit(&bbMoves);
+      to = PopNextBit<Opp(side)>(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
- bbPieces = bbPc(p, side, R);
+  bbPieces = bbPc(p, side, R);
   while (bbPieces) {
-    from = PopFlippedBit(&bbPieces);
+    from = PopNextBit<side>(&bbPieces);
 	bbMoves = GenCache.GetRookMob(OccBb(p), from) & bbOpp;
     
     while (bbMoves) {
-      to = PopFirstBit(&bbMoves);
+      to = PopNextBit<Opp(side)>(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
   bbPieces = bbPc(p, side, Q);
   while (bbPieces) {
-    from = PopFlippedBit(&bbPieces);
+    from = PopNextBit<side>(&bbPieces);
     bbMoves = GenCache.GetQueenMob(OccBb(p), from) & bbOpp;
 	
     while (bbMoves) {
-      to = PopFirstBit(&bbMoves);
+      to = PopNextBit<Opp(side)>(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
-  } else {
-
-    bbMoves = ((bbPc(p, BLACK, P) & bbNotA & bbRANK_2) >> 9) & p->bbCl[WHITE];
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(Q_PROM, to+9, to);
-	  *list++ = SetMove(N_PROM, to+9, to);
-      *list++ = SetMove(R_PROM, to+9, to);
-      *list++ = SetMove(B_PROM, to+9, to);
-    }
-
-    bbMoves = ((bbPc(p, BLACK, P) & bbNotH & bbRANK_2) >> 7) & p->bbCl[WHITE];
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(Q_PROM, to+7, to);
-	  *list++ = SetMove(N_PROM, to+7, to);
-      *list++ = SetMove(R_PROM, to+7, to);
-      *list++ = SetMove(B_PROM, to+7, to);
-    }
+  bbMoves = bbKingAttacks[KingSq(p, side)] & bbOpp;
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    *list++ = SetMove(NORMAL, KingSq(p, side), to);
+  }
+  return list;
+}
 
-    bbMoves = ((bbPc(p, BLACK, P) & bbRANK_2) >> 8) & UnoccBb(p);
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(Q_PROM, to+8, to);
-	  *list++ = SetMove(N_PROM, to+8, to);
-      *list++ = SetMove(R_PROM, to+8, to);
-      *list++ = SetMove(B_PROM, to+8, to);
-    }
+int *GenerateCaptures(sPosition *p, int *list)
+{
+  if (p->side == WHITE) return GenerateCaptures<WHITE>(p, list);
+  else                  return GenerateCaptures<BLACK>(p, list);
+}
 
-    bbMoves = ShiftSW(bbPc(p, BLACK, P) & ~bbRANK_2) & p->bbCl[WHITE];
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(NORMAL, to+9, to);
-    }
+template <int side>
+static int *GenerateQuiet(sPosition *p, int *list)
+{
+  const int up = (side == WHITE) ? 8 : -8;
+  const U64 bbRank2 = (side == WHITE) ? bbRANK_2 : bbRANK_7;
+  const U64 bbRank7 = (side == WHITE) ? bbRANK_7 : bbRANK_2;
+  const int ksFlag  = (side == WHITE) ? W_KS : B_KS;
+  const int qsFlag  = (side == WHITE) ? W_QS : B_QS;
+  const U64 bbKsGap = (side == WHITE) ? (U64)0x0000000000000060 : (U64)0x6000000000000000;
+  const U64 bbQsGap = (side == WHITE) ? (U64)0x000000000000000E : (U64)0x0E00000000000000;
 
-    bbMoves = ShiftSE(bbPc(p, BLACK, P) & ~bbRANK_2) & p->bbCl[WHITE];
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(NORMAL, to+7, to);
-    }
+  U64 bbPieces, bbMoves;
+  U64 bbEmptySq  = UnoccBb(p);
+  U64 bbOccupied = ~bbEmptySq;
+  int from, to;
+
+  // castling
+  if ((p->castleFlags & ksFlag) && !(bbOccupied & bbKsGap))
+    if (!IsAttacked(p, REL_SQ(E1, side), Opp(side)) && !IsAttacked(p, REL_SQ(F1, side), Opp(side)))
+      *list++ = SetMove(CASTLE, REL_SQ(E1, side), REL_SQ(G1, side));
+  if ((p->castleFlags & qsFlag) && !(bbOccupied & bbQsGap))
+    if (!IsAttacked(p, REL_SQ(E1, side), Opp(side)) && !IsAttacked(p, REL_SQ(D1, side), Opp(side)))
+      *list++ = SetMove(CASTLE, REL_SQ(E1, side), REL_SQ(C1, side));
+
+  // pawn moves
+  bbMoves = ShiftFwd<side>(ShiftFwd<side>(bbPc(p, side, P) & bbRank2) & bbEmptySq) & bbEmptySq;
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    *list++ = SetMove(EP_SET, to - 2 * up, to);
+  }
 
-    if ((to = p->epSquare) != NO_SQ) {
-      if (((bbPc(p, BLACK, P) & bbNotA) >> 9) & SqBb(to))
-        *list++ = SetMove(EP_CAP, to+9, to);
-      if (((bbPc(p, BLACK, P) & bbNotH) >> 7) & SqBb(to))
-        *list++ = SetMove(EP_CAP, to+7, to);
-    }
+  bbMoves = ShiftFwd<side>(bbPc(p, side, P) & ~bbRank7) & bbEmptySq;
+  while (bbMoves) {
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    *list++ = SetMove(NORMAL, to - up, to);
+  }
 
+  // knight moves
   bbPieces = bbPc(p, side, N);
   while (bbPieces) {
-    from = PopFirstBit(&bbPieces);
-    bbMoves = bbKnightAttacks[from] & bbOpp;
+    from = PopNextBit<side>(&bbPieces);
+    bbMoves = bbKnightAttacks[from] & bbEmptySq;
 
     while (bbMoves) {
-      to = PopFlippedBit(&bbMoves);
-      *list++ = SetMove(NORMAL,from,to);
+      to = PopNextBit<Opp(side)>(&bbMoves);
+      *list++ = SetMove(NORMAL, from, to);
     }
   }
 
+  // bishop moves
   bbPieces = bbPc(p, side, B);
   while (bbPieces) {
-    from = PopFirstBit(&bbPieces);
-	bbMoves = GenCache.GetBishMob(OccBb(p), from) & bbOpp;
+    from = PopNextBit<side>(&bbPieces);
+	bbMoves = GenCache.GetBishMob(bbOccupied, from) & bbEmptySq;
 
-    while (bbMoves) {
-      to = PopFlippedBit(&bbMoves);
-      *list++ = SetMove(NORMAL,from,to);
+    while (bbMoves) { // serialize moves
+      to = PopNextBit<Opp(side)>(&bbMoves);
+      *list++ = SetMove(NORMAL, from, to);
     }
   }
 
- bbPieces = bbPc(p, side, R);
+  // rook moves
+  bbPieces = bbPc(p, side, R);
   while (bbPieces) {
-    from = PopFirstBit(&bbPieces);
-	bbMoves = GenCache.GetRookMob(OccBb(p), from) & bbOpp;
-    
-    while (bbMoves) {
-      to = PopFlippedBit(&bbMoves);
-      *list++ = SetMove(NORMAL,from,to);
+    from = PopNextBit<side>(&bbPieces);
+	bbMoves = GenCache.GetRookMob(bbOccupied, from) & bbEmptySq;
+
+    while (bbMoves) { // serialize moves
+      to = PopNextBit<Opp(side)>(&bbMoves);
+      *list++ = SetMove(NORMAL, from, to);
     }
   }
 
+  // queen moves
   bbPieces = bbPc(p, side, Q);
   while (bbPieces) {
-    from = PopFirstBit(&bbPieces);
-    bbMoves = GenCache.GetQueenMob(OccBb(p), from) & bbOpp;
-	
-    while (bbMoves) {
-      to = PopFlippedBit(&bbMoves);
-      *list++ = SetMove(NORMAL,from,to);
+    from = PopNextBit<side>(&bbPieces);
+	bbMoves = GenCache.GetQueenMob(bbOccupied, from) & bbEmptySq;
+    
+	while (bbMoves) { // serialize moves
+      to = PopNextBit<Opp(side)>(&bbMoves);
+      *list++ = SetMove(NORMAL, from, to);
     }
   }
 
-  }
+  // king moves
+  bbMoves = bbKingAttacks[KingSq(p, side)] & bbEmptySq;
 
-  bbMoves = bbKingAttacks[KingSq(p, side)] & bbOpp;
-  while (bbMoves) {
-    to = PopNextBit(Opp(side), &bbMoves);
-    *list++ = SetMove(NORMAL,KingSq(p, side),to);
+  while (bbMoves) { // serialize moves
+    to = PopNextBit<Opp(side)>(&bbMoves);
+    *list++ = SetMove(NORMAL, KingSq(p, side), to);
   }
   return list;
 }
 
 int *GenerateQuiet(sPosition *p, int *list)
 {
-  U64 bbPieces, bbMoves;
-  U64 bbEmptySq  = UnoccBb(p);
-  U64 bbOccupied = ~bbEmptySq;
-  int side, from, to;
-
-  side = p->side;
-  if (side == WHITE) {
-    // white castle
-    if ((p->castleFlags & W_KS) && !(bbOccupied & (U64)0x0000000000000060))
-      if (!IsAttacked(p, E1, BLACK) && !IsAttacked(p, F1, BLACK))
-        *list++ = SetMove(CASTLE, E1, G1);
-    if ((p->castleFlags & W_QS) && !(bbOccupied & (U64)0x000000000000000E))
-      if (!IsAttacked(p, E1, BLACK) && !IsAttacked(p, D1, BLACK))
-        *list++ = SetMove(CASTLE, E1, C1);
-
-	// white pawns
-	bbMoves = ((((bbPc(p, WHITE, P) & bbRANK_2) << 8) & bbEmptySq ) << 8) & bbEmptySq;
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(EP_SET, to-16, to);
-    }
+  if (p->side == WHITE) return GenerateQuiet<WHITE>(p, list);
+  else                  return GenerateQuiet<BLACK>(p, list);
+}
 
-	bbMoves = ((bbPc(p, WHITE, P) & ~bbRANK_7) << 8) & bbEmptySq;
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(NORMAL, to-8, to);
-    }
-  } else {
-    
-	// black castle
-	if ((p->castleFlags & B_KS) && !(bbOccupied & (U64)0x6000000000000000))
-      if (!IsAttacked(p, E8, WHITE) && !IsAttacked(p, F8, WHITE))
-        *list++ = SetMove(CASTLE, E8, G8);
-    if ((p->castleFlags & B_QS) && !(bbOccupied & (U64)0x0E00000000000000))
-      if (!IsAttacked(p, E8, WHITE) && !IsAttacked(p, D8, WHITE))
-        *list++ = SetMove(CASTLE, E8, C8);
-		
-    
-	// black pawns
-	bbMoves = ((((bbPc(p, BLACK, P) & bbRANK_7) >> 8) & bbEmptySq) >> 8) & bbEmptySq;
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(EP_SET, to+16, to);
+// Legal move generation. Instead of making every pseudo-legal move and
+// testing IllegalPosition() afterwards, move selector computes checkers
+// and pinned pieces once per node and rejects moves that would leave
+// own king in check with a few bitboard operations (LeavesKingSafe()).
+
+U64 GetCheckers(sPosition *p)
+{
+#ifdef USE_ATTACK_MAPS
+  return p->bbCheckers;
+#else
+  return AttacksTo(p, KingSq(p, p->side)) & p->bbCl[Opp(p->side)];
+#endif
+}
+
+// pieces of the side to move that shield their king from a slider
+
+U64 GetPinned(sPosition *p)
+{
+  int side   = p->side;
+  int kingSq = KingSq(p, side);
+  U64 bbOcc  = OccBb(p);
+  U64 bbOwn  = p->bbCl[side];
+  U64 bbPinned = 0;
+  U64 bbAtt, bbPinners;
+  int sq;
+
+  // straight pins: remove own pieces seen by the king and look again
+  bbAtt = RAttacks(bbOcc, kingSq);
+  bbPinners = RAttacks(bbOcc ^ (bbAtt & bbOwn), kingSq) & ~bbAtt
+            & (bbPc(p, Opp(side), R) | bbPc(p, Opp(side), Q));
+  while (bbPinners) {
+    sq = PopFirstBit(&bbPinners);
+    bbPinned |= RAttacks(bbOcc, sq) & bbAtt & bbOwn;
+  }
+
+  // diagonal pins
+  bbAtt = BAttacks(bbOcc, kingSq);
+  bbPinners = BAttacks(bbOcc ^ (bbAtt & bbOwn), kingSq) & ~bbAtt
+            & (bbPc(p, Opp(side), B) | bbPc(p, Opp(side), Q));
+  while (bbPinners) {
+    sq = PopFirstBit(&bbPinners);
+    bbPinned |= BAttacks(bbOcc, sq) & bbAtt & bbOwn;
+  }
+
+  return bbPinned;
+}
+
+// is square "sq" free from enemy attacks, given occupancy "bbOcc"?
+
+static int IsSafeSquare(sPosition *p, int sq, U64 bbOcc)
+{
+  int opp = Opp(p->side);
+
+  return !( (bbPc(p, opp, P) & bbPawnAttacks[p->side][sq])
+         || (bbPc(p, opp, N) & bbKnightAttacks[sq])
+         || (bbPc(p, opp, K) & bbKingAttacks[sq])
+         || ((bbPc(p, opp, B) | bbPc(p, opp, Q)) & BAttacks(bbOcc, sq))
+         || ((bbPc(p, opp, R) | bbPc(p, opp, Q)) & RAttacks(bbOcc, sq)) );
+}
+
+// squares between king and a checking slider (empty set for other checkers)
+
+static U64 GetBlockSquares(sPosition *p, int kingSq, int checkSq)
+{
+  U64 bbOcc = OccBb(p);
+
+  for (int dir = HOR; dir <= DIAG_HA; dir++)
+    if (bbLineMask[dir][kingSq] & SqBb(checkSq)) {
+      if (dir <= VER) return RAttacks(bbOcc, kingSq) & RAttacks(bbOcc, checkSq) & bbLineMask[dir][kingSq];
+      else            return BAttacks(bbOcc, kingSq) & BAttacks(bbOcc, checkSq) & bbLineMask[dir][kingSq];
     }
-    bbMoves = ((bbPc(p, BLACK, P) & ~bbRANK_2) >> 8) & bbEmptySq;
-    while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
-      *list++ = SetMove(NORMAL, to+8, to);
+  return 0;
+}
+
+// pawn move, expanded into four moves if it is a promotion
+
+static int *AddPawnMove(int *list, int from, int to)
+{
+  if (SqBb(to) & (bbRANK_1 | bbRANK_8))
+    return AddPromotions(list, from, to);
+  *list++ = SetMove(NORMAL, from, to);
+  return list;
+}
+
+// Generates moves that may get the side to move out of check: king moves
+// and, if there is just one checker, captures of the checking piece and 
+// interpositions. Pinned pieces and squares attacked by the opponent are
+// left for LeavesKingSafe().
+
+template <int side>
+static int *GenerateEvasions(sPosition *p, int *list, U64 bbCheckers)
+{
+  const int up = (side == WHITE) ? 8 : -8;
+  const U64 bbRank4 = (side == WHITE) ? bbRANK_4 : bbRANK_5;
+  const U64 bbBack  = (side == WHITE) ? (bbRANK_1 | bbRANK_2) : (bbRANK_7 | bbRANK_8);
+
+  U64 bbPieces, bbMoves, bbTarget;
+  int kingSq = KingSq(p, side);
+  int from, to;
+
+  // king moves
+  bbMoves = bbKingAttacks[kingSq] & ~p->bbCl[side];
+  while (bbMoves) {
+    to = PopFirstBit(&bbMoves);
+    *list++ = SetMove(NORMAL, kingSq, to);
+  }
+
+  // in double check only the king can move
+  if (MoreThanOne(bbCheckers)) return list;
+
+  int checkSq = FirstOne(bbCheckers);
+  U64 bbBlock = GetBlockSquares(p, kingSq, checkSq);
+  bbTarget = bbCheckers | bbBlock;
+
+  // pawn captures of the checking piece
+  bbPieces = bbPc(p, side, P) & bbPawnAttacks[Opp(side)][checkSq];
+  while (bbPieces) {
+    from = PopFirstBit(&bbPieces);
+    list = AddPawnMove(list, from, checkSq);
+  }
+
+  // en passant capture, either of the checking pawn or to a blocking square
+  if ((to = p->epSquare) != NO_SQ
+  && ((bbBlock & SqBb(to)) || checkSq == (to ^ 8)) ) {
+    bbPieces = bbPc(p, side, P) & bbPawnAttacks[Opp(side)][to];
+    while (bbPieces) {
+      from = PopFirstBit(&bbPieces);
+      *list++ = SetMove(EP_CAP, from, to);
     }
   }
 
-  // knight moves
+  // pawn pushes to blocking squares (a pawn never moves to its first two ranks)
+  bbMoves = bbBlock & ~bbBack;
+  while (bbMoves) {
+    to = PopFirstBit(&bbMoves);
+    from = to - up;
+    if (p->pc[from] == Pc(side, P))
+      list = AddPawnMove(list, from, to);
+    else if ((SqBb(to) & bbRank4)
+         &&  p->pc[from] == NO_PC
+         &&  p->pc[from - up] == Pc(side, P))
+      *list++ = SetMove(EP_SET, from - up, to);
+  }
+
+  // pieces
   bbPieces = bbPc(p, side, N);
   while (bbPieces) {
-    from = PopNextBit(side, &bbPieces);
-    bbMoves = bbKnightAttacks[from] & bbEmptySq;
-
+    from = PopFirstBit(&bbPieces);
+    bbMoves = bbKnightAttacks[from] & bbTarget;
     while (bbMoves) {
-      to = PopNextBit(Opp(side), &bbMoves);
+      to = PopFirstBit(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
-  // bishop moves
   bbPieces = bbPc(p, side, B);
   while (bbPieces) {
-    from = PopNextBit(side, &bbPieces);
-	bbMoves = GenCache.GetBishMob(OccBb(p), from) & bbEmptySq;
-
-    while (bbMoves) { // serialize moves
-      to = PopNextBit(Opp(side), &bbMoves);
+    from = PopFirstBit(&bbPieces);
+    bbMoves = GenCache.GetBishMob(OccBb(p), from) & bbTarget;
+    while (bbMoves) {
+      to = PopFirstBit(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
-  // rook moves
   bbPieces = bbPc(p, side, R);
   while (bbPieces) {
-    from = PopNextBit(side, &bbPieces);
-	bbMoves = GenCache.GetRookMob(OccBb(p), from) & bbEmptySq;
-
-    while (bbMoves) { // serialize moves
-      to = PopNextBit(Opp(side), &bbMoves);
+    from = PopFirstBit(&bbPieces);
+    bbMoves = GenCache.GetRookMob(OccBb(p), from) & bbTarget;
+    while (bbMoves) {
+      to = PopFirstBit(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
-  // queen moves
   bbPieces = bbPc(p, side, Q);
   while (bbPieces) {
-    from = PopNextBit(side, &bbPieces);
-	bbMoves = GenCache.GetQueenMob(OccBb(p), from) & bbEmptySq;
-    
-	while (bbMoves) { // serialize moves
-      to = PopNextBit(Opp(side), &bbMoves);
+    from = PopFirstBit(&bbPieces);
+    bbMoves = GenCache.GetQueenMob(OccBb(p), from) & bbTarget;
+    while (bbMoves) {
+      to = PopFirstBit(&bbMoves);
       *list++ = SetMove(NORMAL, from, to);
     }
   }
 
-  // king moves
-  bbMoves = bbKingAttacks[KingSq(p, side)] & bbEmptySq;
+  return list;
+}
 
-  while (bbMoves) { // serialize moves
-    to = PopNextBit(Opp(side), &bbMoves);
-    *list++ = SetMove(NORMAL, KingSq(p, side), to);
+int *GenerateEvasions(sPosition *p, int *list, U64 bbCheckers)
+{
+  if (p->side == WHITE) return GenerateEvasions<WHITE>(p, list, bbCheckers);
+  else                  return GenerateEvasions<BLACK>(p, list, bbCheckers);
+}
+
+// Tells whether a pseudo-legal move is legal, using checkers and pinned 
+// pieces computed for the current node by GetCheckers() and GetPinned()
+
+int LeavesKingSafe(sPosition *p, int move, U64 bbPinned, U64 bbCheckers)
+{
+  int fsq    = Fsq(move);
+  int tsq    = Tsq(move);
+  int kingSq = KingSq(p, p->side);
+
+  // king moves: target square must not be attacked once the king has left its square
+  if (fsq == kingSq)
+    return IsSafeSquare(p, tsq, OccBb(p) ^ SqBb(fsq));
+
+  // en passant may uncover an attack along the rank, so it is tested directly
+  if (MoveType(move) == EP_CAP) {
+    int capSq = tsq ^ 8;
+    U64 bbOcc = OccBb(p) ^ SqBb(fsq) ^ SqBb(tsq) ^ SqBb(capSq);
+    int opp = Opp(p->side);
+
+    if (bbCheckers & ~SqBb(capSq) & (p->bbTp[P] | p->bbTp[N])) return 0;
+    return !( ((bbPc(p, opp, B) | bbPc(p, opp, Q)) & BAttacks(bbOcc, kingSq))
+           || ((bbPc(p, opp, R) | bbPc(p, opp, Q)) & RAttacks(bbOcc, kingSq)) );
   }
-  return list;
+
+  // in check: a single checker must be captured or blocked
+  if (bbCheckers) {
+    if (MoreThanOne(bbCheckers)) return 0;
+    int checkSq = FirstOne(bbCheckers);
+    if (!((bbCheckers | GetBlockSquares(p, kingSq, checkSq)) & SqBb(tsq))) return 0;
+  }
+
+  // pinned piece may move only along the line joining it with the king
+  if (bbPinned & SqBb(fsq)) {
+    for (int dir = HOR; dir <= DIAG_HA; dir++)
+      if (bbLineMask[dir][kingSq] & SqBb(fsq))
+        return (bbLineMask[dir][kingSq] & SqBb(tsq)) != 0;
+  }
+
+  return 1;
 }
@@ -45,4 +45,4 @@ public:
 	 int GetRefutation(int lastMove);
 };
 
-extern sHistory History;
+extern THREAD_LOCAL sHistory History;
@@ -37,6 +37,7 @@ void Init(void)
   }
 
   InitKindergartenBitboards();
+  InitSliderAttacks(BestSliderBackend());
   InitPawnAttacks();
   InitKnightAttacks();
   InitKingAttacks();     
@@ -0,0 +1,214 @@
+/*
+  Rodent, a UCI chess playing engine derived from Sungorus 1.4
+  Copyright (C) 2009-2011 Pablo Vazquez (Sungorus author)
+  Copyright (C) 2011-2014 Pawel Koziol
+
+  Rodent is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  Rodent is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Asynchronous input. A reader thread owns stdin and passes commands to
+the engine thread (the one running sParser::UciLoop and the search)
+through a small queue. Commands that must take effect while the engine
+is busy are handled by the reader itself:
+
+- "stop" and "ponderhit" set flags polled by the search,
+- "isready" is answered at once, unless some earlier command is still
+  waiting to be executed,
+- "quit" and the end of input abort the search.
+
+"stop" and "ponderhit" refer to the last command sent before them. If
+the engine thread has not started it yet, the flag is set when it does
+(in GetLine and ParseGo), so no signal is lost whatever the timing.
+*/
+
+#if defined(_WIN32) || defined(_WIN64)
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include "rodent.h"
+#include "parser.h"
+#include "input.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+static CRITICAL_SECTION inputLock;
+static CONDITION_VARIABLE inputCond;
+static DWORD WINAPI ReaderEntry(LPVOID) { Input.ReaderLoop(); return 0; }
+#else
+static pthread_mutex_t inputLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  inputCond = PTHREAD_COND_INITIALIZER;
+static void *ReaderEntry(void *) { Input.ReaderLoop(); return NULL; }
+#endif
+
+void sInput::Lock(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  EnterCriticalSection(&inputLock);
+#else
+  pthread_mutex_lock(&inputLock);
+#endif
+}
+
+void sInput::Unlock(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  LeaveCriticalSection(&inputLock);
+#else
+  pthread_mutex_unlock(&inputLock);
+#endif
+}
+
+// called with the lock held; both threads wait on the same condition
+
+void sInput::Wait(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  SleepConditionVariableCS(&inputCond, &inputLock, INFINITE);
+#else
+  pthread_cond_wait(&inputCond, &inputLock);
+#endif
+}
+
+void sInput::Signal(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  WakeAllConditionVariable(&inputCond);
+#else
+  pthread_cond_broadcast(&inputCond);
+#endif
+}
+
+void sInput::Init(void)
+{
+  head         = 0;
+  tail         = 0;
+  pending      = 0;
+  isEof        = 0;
+  isQuitting   = 0;
+  engineState  = ENGINE_IDLE;
+  nOfQueued    = 0;
+  nOfStarted   = 0;
+  stopFor      = -1;
+  ponderhitFor = -1;
+
+#if defined(_WIN32) || defined(_WIN64)
+  InitializeCriticalSection(&inputLock);
+  InitializeConditionVariable(&inputCond);
+  CloseHandle(CreateThread(NULL, 0, ReaderEntry, NULL, 0, NULL));
+#else
+  pthread_t thread;
+  pthread_create(&thread, NULL, ReaderEntry, NULL);
+  pthread_detach(thread);
+#endif
+}
+
+// called by the reader with the lock held, waits if the queue is full
+
+void sInput::Push(char *str)
+{
+  while ((head + 1) % INPUT_SLOTS == tail) Wait();
+  strcpy(queue[head], str);
+  head = (head + 1) % INPUT_SLOTS;
+  Signal();
+}
+
+void sInput::ReaderLoop(void)
+{
+  char line[INPUT_LENGTH], token[80], *ptr;
+
+  for (;;) {
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+      Lock();
+      isEof = 1;
+      isQuitting = 1;
+      stopSearch = 1;
+      Signal();
+      Unlock();
+      return;
+    }
+    if ((ptr = strchr(line, '\n')) != NULL)
+      *ptr = '\0';
+
+    Parser.ParseToken(line, token);
+    if (*token == '\0') continue;
+
+    Lock();
+    if (strcmp(token, "stop") == 0) {
+      stopFor = nOfQueued;
+      if (stopFor == nOfStarted) stopSearch = 1;
+    } else if (strcmp(token, "ponderhit") == 0) {
+      ponderhitFor = nOfQueued;
+      if (ponderhitFor == nOfStarted) pondering = 0;
+    } else if (strcmp(token, "isready") == 0 && !pending && engineState != ENGINE_BUSY) {
+      printf("readyok\n"); // nothing to catch up with, so we can answer even during search
+    } else {
+      if (strcmp(token, "quit") == 0) {
+        isQuitting = 1;
+        stopSearch = 1;
+      }
+      if (strcmp(token, "go") != 0) pending++;
+      if (strcmp(token, "isready") != 0) nOfQueued++; // isready is not a target for stop
+      Push(line);
+    }
+    Unlock();
+  }
+}
+
+// Called by the engine thread to get the next command, returns 0 at the end
+// of input. Queued "isready" is answered here, after everything sent before it.
+
+int sInput::GetLine(char *str, int n)
+{
+  char token[80];
+
+  Lock();
+  engineState = ENGINE_IDLE;
+
+  for (;;) {
+    while (head == tail && !isEof) Wait();
+    if (head == tail) {
+      Unlock();
+      return 0;
+    }
+
+    strncpy(str, queue[tail], n - 1);
+    str[n - 1] = '\0';
+    tail = (tail + 1) % INPUT_SLOTS;
+    Signal();
+
+    Parser.ParseToken(str, token);
+    if (strcmp(token, "go") != 0) pending--;
+    if (strcmp(token, "isready") != 0) break;
+    printf("readyok\n");
+  }
+
+  nOfStarted++;
+  engineState = (strcmp(token, "go") == 0) ? ENGINE_SEARCHING : ENGINE_BUSY;
+  stopSearch  = (stopFor == nOfStarted || isQuitting);
+  Unlock();
+  return 1;
+}
+
+// true if "ponderhit" has already arrived for the current command
+
+int sInput::PonderhitReceived(void)
+{
+  Lock();
+  int result = (ponderhitFor == nOfStarted);
+  Unlock();
+  return result;
+}
@@ -0,0 +1,51 @@
+/*
+  Rodent, a UCI chess playing engine derived from Sungorus 1.4
+  Copyright (C) 2009-2011 Pablo Vazquez (Sungorus author)
+  Copyright (C) 2011-2014 Pawel Koziol
+
+  Rodent is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  Rodent is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#define INPUT_SLOTS  16     // commands waiting for the engine thread
+#define INPUT_LENGTH 4096   // must hold the longest "position ... moves" command
+
+enum eEngineState { ENGINE_IDLE, ENGINE_BUSY, ENGINE_SEARCHING };
+
+struct sInput { // reads stdin on its own thread, so that search never waits for input
+private:
+	char queue[INPUT_SLOTS][INPUT_LENGTH];
+	int head, tail;          // queue[tail] is the next command for the engine thread
+	int pending;             // queued commands other than "go"
+	int isEof;
+	int isQuitting;          // "quit" or the end of input: every search must stop
+	int engineState;         // what the engine thread is doing now (see eEngineState)
+	int nOfQueued;           // commands queued so far
+	int nOfStarted;          // commands taken by the engine thread so far (the current one has this number)
+	int stopFor;             // number of the command that "stop" refers to
+	int ponderhitFor;        // number of the command that "ponderhit" refers to
+	void Lock(void);
+	void Unlock(void);
+	void Wait(void);
+	void Signal(void);
+	void Push(char *str);
+public:
+	void Init(void);
+	void ReaderLoop(void);
+	int  GetLine(char *str, int n);
+	int  PonderhitReceived(void);
+}; // implemented in input.c
+
+extern sInput Input;
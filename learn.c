@@ -18,6 +18,7 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 #include "stdlib.h"
 #include "rodent.h"
 #include "data.h"
@@ -28,11 +29,21 @@
 void sLearner::Init(char *fileName)
 {
 	 FILE *learnFile; 
-	 char line[256];
+	 char line[256], header[256];
 	 learnSize = 0;
 
       // exit if learn file doesn't exist
 	  if ( (learnFile = fopen(fileName, "r")) == NULL ) return;
+
+      // entries are keyed by hash keys, so a file written with another key set
+      // (say, by a version with a different Zobrist generator) is useless;
+      // it is ignored here and overwritten by the next Save()
+	  sprintf(header, LEARN_FILE_TAG llu_format "\n", TransTable.ZobristCheck());
+	  if ( !fgets(line, 256, learnFile) || strcmp(line, header) ) {
+		  printf("info string %s was written with different hash keys, learning data is reset\n", fileName);
+		  fclose(learnFile);
+		  return;
+	  }
      
 	 // TODO: read learn file line by line, increasing age of each entry
 	  	  while ( fgets(line, 256, learnFile) ) {
@@ -107,6 +118,7 @@ void sLearner::Save(char *fileName)
 
      if (!Data.useLearning) return;
      learnFile = fopen(fileName,"w"); 
+     fprintf(learnFile, LEARN_FILE_TAG llu_format "\n", TransTable.ZobristCheck());
 
 	 for (int i = 0; i < learnSize; i++ ) {
 		 if (learnData[i].hash != 0)
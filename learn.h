@@ -20,6 +20,7 @@
 #pragma once
 
 #define MAX_LEARN_SIZE 48000
+#define LEARN_FILE_TAG "RodentLearn " // first line of lrn.dat, followed by ZobristCheck()
 
 struct sLearnEntry {
    U64 hash;
@@ -27,6 +27,7 @@
 #include "trans.h"
 #include "hist.h"
 #include "parser.h"
+#include "input.h"
 #include "learn.h"
 #include "book.h"
 
@@ -34,14 +35,19 @@ int flagProtocol;
 
 // struct instances
 sParser     Parser;       // UCI parser  
+sInput      Input;        // stdin reader thread
 sData       Data;         // configurable data affecting engine performance
-sEvaluator  Eval;         // evaluation function and subroutines 
-sGenCache   GenCache;     // caching generated bitboards for minimal speedup
+THREAD_LOCAL sEvaluator Eval;     // evaluation function and subroutines (one per thread)
+THREAD_LOCAL sGenCache  GenCache; // caching generated bitboards for minimal speedup
 sManipulator Manipulator; // functions for making and unmaking moves
-sSearcher   Searcher;     // search function and subroutines
+THREAD_LOCAL sSearcher Searcher;  // search function and subroutines
+THREAD_LOCAL sRepStack RepStack;  // keys of earlier positions, for detecting repetitions
+sSmp        Smp;          // helper threads for parallel search
 sTimer      Timer;        // setting and observing time limits
 sTransTable TransTable;   // transposition table
-sHistory    History;      // history and killer tables
+sQsTable    QsTable;      // quiescence search results
+sEvalTable  EvalTable;    // scores returned by the evaluation function
+THREAD_LOCAL sHistory History;    // history and killer tables
 sLearner    Learner;      // position learning facility
 sBook       Book;         // opening book 
 
@@ -50,11 +56,13 @@ int main()
   sPosition p;
   flagProtocol = PROTO_TXT;
   Init();
+  GenCache.Init();
   Parser.ReadIniFile("rodent.ini"); // initialize variables governing how the engine appears to a GUI
   History.OnNewGame();
   Learner.Init("lrn.dat");
   Book.Init(&p);
   Searcher.Init();
+  Smp.Init();
   Book.bookName = "rodent.bin";
   Book.OpenPolyglot();
   Parser.UciLoop();
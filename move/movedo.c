@@ -20,16 +20,24 @@
 #include "../bitboard/bitboard.h"
 #include "../data.h"
 #include "../rodent.h"
+#include "../trans.h"
+#include "../eval/eval.h"
 
-void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
+// Make and unmake are templates on the moving side, so that every
+// Opp(side) and color index below is a constant.
+
+template <int side>
+static void DoSideMove(sPosition *p, int move, UNDO *u)
 {
-  int side = p->side;         // moving side 
   int fsq  = Fsq(move);       // start square
   int tsq  = Tsq(move);       // target square
   int ftp  = TpOnSq(p, fsq);  // moving piece
   int ttp  = TpOnSq(p, tsq);  // captured piece
 
   U64 bbMove = SqBb(fsq) | SqBb(tsq); // optimization from Stockfish
+#ifdef USE_ATTACK_MAPS
+  U64 bbChanged = bbMove;             // squares whose occupancy changes
+#endif
 
   // save data for undoing a move
   u->ttp = ttp;
@@ -38,8 +46,16 @@ void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
   u->reversibleMoves = p->reversibleMoves;
   u->hashKey = p->hashKey;
   u->pawnKey = p->pawnKey;
+  u->matKey = p->matKey;
+#ifdef USE_ATTACK_MAPS
+  u->bbAttacks[WHITE] = p->bbAttacks[WHITE];
+  u->bbAttacks[BLACK] = p->bbAttacks[BLACK];
+  u->bbPawnAtt[WHITE] = p->bbPawnAtt[WHITE];
+  u->bbPawnAtt[BLACK] = p->bbPawnAtt[BLACK];
+  u->bbCheckers = p->bbCheckers;
+#endif
 
-  p->repetitionList[p->head++] = p->hashKey;
+  RepStack.keys[p->head++] = p->hashKey;
 
   // update reversible move counter (zeroing is done on captures and pawn moves)
   p->reversibleMoves++;
@@ -64,8 +80,7 @@ void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
   } 
   p->bbCl[side]  ^= bbMove;
   p->bbTp[ftp]   ^= bbMove;
-  p->pstMg[side] += Data.pstMg[side][ftp][tsq] - Data.pstMg[side][ftp][fsq];
-  p->pstEg[side] += Data.pstEg[side][ftp][tsq] - Data.pstEg[side][ftp][fsq];
+  p->pst[side] += Data.pst[side][ftp][tsq] - Data.pst[side][ftp][fsq];
 
   // on a king move update king location data
   if (ftp == K) p->kingSquare[side] = tsq;
@@ -79,10 +94,10 @@ void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
     p->bbCl[Opp(side)] ^= SqBb(tsq);
     p->bbTp[ttp]       ^= SqBb(tsq);
 	p->pcCount[Opp(side)][ttp]--;
+	p->matKey ^= zobPiece[Pc(Opp(side), ttp)][p->pcCount[Opp(side)][ttp]];
     p->pieceMat[Opp(side)] -= Data.matValue[ttp];
 	p->phase               -= Data.phaseValue[ttp]; 
-    p->pstMg[Opp(side)]    -= Data.pstMg[Opp(side)][ttp][tsq];
-	p->pstEg[Opp(side)]    -= Data.pstEg[Opp(side)][ttp][tsq];
+    p->pst[Opp(side)]      -= Data.pst[Opp(side)][ttp][tsq];
   }
   
   switch (MoveType(move)) {
@@ -103,8 +118,10 @@ void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
     p->hashKey     ^= zobPiece[Pc(side, R)][fsq] ^ zobPiece[Pc(side, R)][tsq];
     p->bbCl[side]  ^= SqBb(fsq) | SqBb(tsq);
     p->bbTp[R]     ^= SqBb(fsq) | SqBb(tsq);
-    p->pstMg[side] += Data.pstMg[side][R][tsq] - Data.pstMg[side][R][fsq];
-	p->pstEg[side] += Data.pstEg[side][R][tsq] - Data.pstEg[side][R][fsq];
+    p->pst[side] += Data.pst[side][R][tsq] - Data.pst[side][R][fsq];
+#ifdef USE_ATTACK_MAPS
+    bbChanged |= SqBb(fsq) | SqBb(tsq);
+#endif
     break;
 
   case EP_CAP:
@@ -115,9 +132,12 @@ void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
     p->bbCl[Opp(side)] ^= SqBb(tsq);
     p->bbTp[P] ^= SqBb(tsq);
 	p->pcCount[Opp(side)][P]--;
+	p->matKey ^= zobPiece[Pc(Opp(side), P)][p->pcCount[Opp(side)][P]];
 	p->phase             -= Data.phaseValue[P];
-    p->pstMg[Opp(side)] -= Data.pstMg[Opp(side)][P][tsq];
-	p->pstEg[Opp(side)] -= Data.pstEg[Opp(side)][P][tsq];
+    p->pst[Opp(side)] -= Data.pst[Opp(side)][P][tsq];
+#ifdef USE_ATTACK_MAPS
+    bbChanged |= SqBb(tsq);
+#endif
     break;
 
   case EP_SET:
@@ -139,17 +159,30 @@ void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
 	p->pawnKey  ^= zobPiece[Pc(side, P)][tsq];
     p->bbTp[P]  ^= SqBb(tsq);
     p->bbTp[ftp]^= SqBb(tsq);
+	p->matKey ^= zobPiece[Pc(side, ftp)][p->pcCount[side][ftp]];
 	p->pcCount[side][ftp]++;
 	p->pcCount[side][P]--;
+	p->matKey ^= zobPiece[Pc(side, P)][p->pcCount[side][P]];
 	p->pieceMat[side] += Data.matValue[ftp];
 	p->phase          += Data.phaseValue[ftp]       - Data.phaseValue[P];
-    p->pstMg[side]    += Data.pstMg[side][ftp][tsq] - Data.pstMg[side][P][tsq];
-	p->pstEg[side]    += Data.pstEg[side][ftp][tsq] - Data.pstEg[side][P][tsq];
+    p->pst[side]    += Data.pst[side][ftp][tsq] - Data.pst[side][P][tsq];
     break;
 
   }
-  p->side ^= 1;
+  p->side = Opp(side);
   p->hashKey ^= SIDE_RANDOM;
+  TransTable.Prefetch(p->hashKey);
+  if (p->pawnKey != u->pawnKey) Eval.PrefetchPawnEntry(p->pawnKey);
+#ifdef USE_ATTACK_MAPS
+  UpdateAttackMaps(p, bbChanged);
+  SumAttackMaps(p);
+#endif
+}
+
+void sManipulator::DoMove(sPosition *p, int move, UNDO *u)
+{
+  if (p->side == WHITE) DoSideMove<WHITE>(p, move, u);
+  else                  DoSideMove<BLACK>(p, move, u);
 }
 
 void sManipulator::DoNull(sPosition *p, UNDO *u)
@@ -157,7 +190,10 @@ void sManipulator::DoNull(sPosition *p, UNDO *u)
   u->epSquare = p->epSquare;
   u->hashKey  = p->hashKey;
   u->pawnKey  = p->pawnKey;
-  p->repetitionList[p->head++] = p->hashKey;
+#ifdef USE_ATTACK_MAPS
+  u->bbCheckers = p->bbCheckers;
+#endif
+  RepStack.keys[p->head++] = p->hashKey;
   p->reversibleMoves++;
 
   if (p->epSquare != NO_SQ) {
@@ -167,4 +203,8 @@ void sManipulator::DoNull(sPosition *p, UNDO *u)
 
   p->side ^= 1;
   p->hashKey ^= SIDE_RANDOM;
+  TransTable.Prefetch(p->hashKey);
+#ifdef USE_ATTACK_MAPS
+  p->bbCheckers = 0; // the side to move now could not be in check before
+#endif
 }
@@ -21,29 +21,32 @@
 #include "../bitboard/bitboard.h"
 #include "../data.h"
 
-void sManipulator::UndoMove(sPosition *p, int move, UNDO *u)
+template <int side>
+static void UndoSideMove(sPosition *p, int move, UNDO *u)
 {
-  int side = Opp(p->side);   // moving side
   int fsq  = Fsq(move);      // start square
   int tsq  = Tsq(move);      // target square
   int ftp  = TpOnSq(p, tsq); // moving piece
   int ttp  = u->ttp;         // captured piece
 
   U64 bbMove = SqBb(fsq) | SqBb(tsq); // optimization from Stockfish
+#ifdef USE_ATTACK_MAPS
+  U64 bbChanged = bbMove;
+#endif
 
   p->castleFlags = u->castleFlags;
   p->epSquare = u->epSquare;
   p->reversibleMoves = u->reversibleMoves;
   p->hashKey = u->hashKey;
   p->pawnKey = u->pawnKey;
+  p->matKey = u->matKey;
   p->head--;
 
   p->pc[fsq] = Pc(side, ftp);
   p->pc[tsq] = NO_PC;
   p->bbCl[side] ^= bbMove;
   p->bbTp[ftp]  ^= bbMove;
-  p->pstMg[side] += Data.pstMg[side][ftp][fsq] - Data.pstMg[side][ftp][tsq]; 
-  p->pstEg[side] += Data.pstEg[side][ftp][fsq] - Data.pstEg[side][ftp][tsq]; 
+  p->pst[side] += Data.pst[side][ftp][fsq] - Data.pst[side][ftp][tsq]; 
   
   // on king move update king location data
   if (ftp == K) p->kingSquare[side] = fsq;
@@ -56,8 +59,7 @@ void sManipulator::UndoMove(sPosition *p, int move, UNDO *u)
 	p->pcCount[Opp(side)] [ttp]++;
     p->pieceMat[Opp(side)] += Data.matValue[ttp];
 	p->phase               += Data.phaseValue[ttp];
-    p->pstMg[Opp(side)]    += Data.pstMg[Opp(side)][ttp][tsq];
-	p->pstEg[Opp(side)]    += Data.pstEg[Opp(side)][ttp][tsq];
+    p->pst[Opp(side)]      += Data.pst[Opp(side)][ttp][tsq];
   }
 
   switch (MoveType(move)) {
@@ -77,8 +79,10 @@ void sManipulator::UndoMove(sPosition *p, int move, UNDO *u)
     p->pc[fsq] = Pc(side, R);
     p->bbCl[side] ^= SqBb(fsq) | SqBb(tsq);
     p->bbTp[R] ^= SqBb(fsq) | SqBb(tsq);
-    p->pstMg[side] += Data.pstMg[side][R][fsq] - Data.pstMg[side][R][tsq];
-	p->pstEg[side] += Data.pstEg[side][R][fsq] - Data.pstEg[side][R][tsq];
+    p->pst[side] += Data.pst[side][R][fsq] - Data.pst[side][R][tsq];
+#ifdef USE_ATTACK_MAPS
+    bbChanged |= SqBb(fsq) | SqBb(tsq);
+#endif
     break;
 
   case EP_CAP:
@@ -88,8 +92,10 @@ void sManipulator::UndoMove(sPosition *p, int move, UNDO *u)
     p->bbTp[P] ^= SqBb(tsq);
 	p->pcCount[Opp(side)] [P]++;
 	p->phase            += Data.phaseValue[P];
-    p->pstMg[Opp(side)] += Data.pstMg[Opp(side)][P][tsq];
-	p->pstEg[Opp(side)] += Data.pstEg[Opp(side)][P][tsq];
+    p->pst[Opp(side)] += Data.pst[Opp(side)][P][tsq];
+#ifdef USE_ATTACK_MAPS
+    bbChanged |= SqBb(tsq);
+#endif
     break;
 
   case EP_SET:
@@ -103,11 +109,26 @@ void sManipulator::UndoMove(sPosition *p, int move, UNDO *u)
 	p->pcCount[side][ftp]--;
     p->pieceMat[side] -= Data.matValue[ftp];
 	p->phase          += Data.phaseValue[P]         - Data.phaseValue[ftp];
-    p->pstMg[side]    += Data.pstMg[side][P][fsq] - Data.pstMg[side][ftp][fsq];
-	p->pstEg[side]    += Data.pstEg[side][P][fsq] - Data.pstEg[side][ftp][fsq];
+    p->pst[side]    += Data.pst[side][P][fsq] - Data.pst[side][ftp][fsq];
     break;
   }
-  p->side ^= 1;
+  p->side = side;
+
+#ifdef USE_ATTACK_MAPS
+  // attacks of single pieces are computed again, sums are restored
+  UpdateAttackMaps(p, bbChanged);
+  p->bbAttacks[WHITE] = u->bbAttacks[WHITE];
+  p->bbAttacks[BLACK] = u->bbAttacks[BLACK];
+  p->bbPawnAtt[WHITE] = u->bbPawnAtt[WHITE];
+  p->bbPawnAtt[BLACK] = u->bbPawnAtt[BLACK];
+  p->bbCheckers = u->bbCheckers;
+#endif
+}
+
+void sManipulator::UndoMove(sPosition *p, int move, UNDO *u)
+{
+  if (p->side == BLACK) UndoSideMove<WHITE>(p, move, u); // side of the move, not the side to move
+  else                  UndoSideMove<BLACK>(p, move, u);
 }
 
 void sManipulator::UndoNull(sPosition *p, UNDO *u)
@@ -118,4 +139,7 @@ void sManipulator::UndoNull(sPosition *p, UNDO *u)
   p->head--;
   p->reversibleMoves--;
   p->side ^= 1;
+#ifdef USE_ATTACK_MAPS
+  p->bbCheckers = u->bbCheckers;
+#endif
 }
@@ -31,15 +31,14 @@
 #include "bitboard/bitboard.h"  // for SqBb and REL_SQ macros
 #include "search/search.h"
 #include "parser.h"
+#include "input.h"
+
+// commands are read from stdin by a separate thread (see input.c)
 
 void sParser::ReadLine(char *str, int n)
 {
-  char *ptr;
-
-  if (fgets(str, n, stdin) == NULL)
+  if (!Input.GetLine(str, n))
     exit(0);
-  if ((ptr = strchr(str, '\n')) != NULL)
-    *ptr = '\0';
 }
 
 char *sParser::ParseToken(char *string, char *token)
@@ -59,8 +58,12 @@ void sParser::UciLoop(void)
 
   setbuf(stdin, NULL);
   setbuf(stdout, NULL);
+  Input.Init();
   SetPosition(p, START_POS);
   TransTable.Alloc(16);
+  QsTable.Alloc(1);
+  EvalTable.Alloc(4);
+  Eval.AllocPawnTable(Data.pawnHash);
 
   for (;;) {
     ReadLine(command, sizeof(command));
@@ -112,10 +115,31 @@ void sParser::UciLoop(void)
       printf(" Command \"bench 8\" should search %d nodes \n", BENCH_8 );
     } else if (strcmp(token, "bench") == 0) {
 		ptr = ParseToken(ptr, token);
-		Searcher.Bench(atoi(token) );
+		int depth = atoi(token);
+		ptr = ParseToken(ptr, token);
+		Searcher.Bench(depth, atoi(token) ); // optional thread count
+    } else if (strcmp(token, "ttstats") == 0) {
+		Searcher.DisplayTtStats();
+    } else if (strcmp(token, "savehash") == 0) {
+		ptr = ParseToken(ptr, token);
+		TransTable.Save(token);
+    } else if (strcmp(token, "loadhash") == 0) {
+		ptr = ParseToken(ptr, token);
+		TransTable.Load(token);
     } else if (strcmp(token, "perft") == 0) {
 		ptr = ParseToken(ptr, token);
 		Searcher.ShowPerft(p, atoi(token) );
+    } else if (strcmp(token, "keystats") == 0) {
+		ptr = ParseToken(ptr, token);
+		Searcher.KeyStats(p, atoi(token) );
+    } else if (strcmp(token, "seebench") == 0) {
+		ptr = ParseToken(ptr, token);
+		Searcher.SeeBench(p, atoi(token) );
+    } else if (strcmp(token, "evalbench") == 0) {
+		ptr = ParseToken(ptr, token);
+		Searcher.EvalBench(p, atoi(token) );
+    } else if (strcmp(token, "sliderbench") == 0) {
+		BenchSliders();
     } else if (strcmp(token, "divide") == 0) {
 		ptr = ParseToken(ptr, token);
 		Searcher.Divide(p, 0, atoi(token) );
@@ -191,8 +215,21 @@ void sParser::SetOption(char *ptr)
 	Data.bookFilter = atoi(value);
   } else if (strcmp(name, "Hash") == 0) {
     TransTable.Alloc(atoi(value));
+  } else if (strcmp(name, "QHash") == 0) {
+    QsTable.Alloc(atoi(value));
+  } else if (strcmp(name, "EvalHash") == 0) {
+    EvalTable.Alloc(atoi(value));
+  } else if (strcmp(name, "PawnHash") == 0) {
+    Data.pawnHash = Max(1, Min(atoi(value), 256));
+    Eval.AllocPawnTable(Data.pawnHash); // helper threads resize their tables when they start searching
   } else if (strcmp(name, "Clear Hash") == 0) {
     TransTable.Clear();
+    QsTable.Clear();
+    EvalTable.Clear();
+  } else if (strcmp(name, "MultiPV") == 0) {
+    Data.multiPv = Max(1, Min(atoi(value), MAX_PV));
+  } else if (strcmp(name, "Threads") == 0) {
+    Smp.SetThreads(atoi(value));
   } else if (strcmp(name, "Strength") == 0) {
 	   char styleName[30] = "personalities/";	   
 	   strcat(styleName,value);
@@ -255,8 +292,13 @@ void sParser::PrintUciOptions()
 	printf("option name Analyse type check default false\n", Data.isAnalyzing);
 	printf("option name UseBook type check default true\n", Data.useBook);
 	printf("option name PositionLearning type check default false\n", Data.useLearning);
-    printf("option name Hash type spin default 16 min 1 max 4096\n");
+    printf("option name Hash type spin default 16 min 1 max 1048576\n");
+    printf("option name QHash type spin default 1 min 1 max 256\n");
+    printf("option name EvalHash type spin default 4 min 0 max 1024\n");
+    printf("option name PawnHash type spin default %d min 1 max 256\n", Data.pawnHash);
     printf("option name Clear Hash type button\n");
+    printf("option name Threads type spin default 1 min 1 max %d\n", MAX_THREADS);
+    printf("option name MultiPV type spin default 1 min 1 max %d\n", MAX_PV);
 }
 
 void sParser::ParsePosition(sPosition *p, char *ptr)
@@ -344,6 +386,9 @@ void sParser::ParseGo(sPosition *p, char *ptr)
 	}
   }
 
+  // ponderhit might have arrived before we started
+  if (pondering && Input.PonderhitReceived()) pondering = 0;
+
   Timer.SetSideData(p->side);
   Timer.SetMoveTiming();
   
@@ -435,8 +480,8 @@ void sParser::PrintBoard(sPosition *p)
    printf("%d",Rank(A1));
 
    printf("Polyglot     hash: %016llX \n", Book.GetPolyglotKey(p) );
-   printf("Incremental  hash: %016llX pawn: %016llX \n", p->hashKey, p->pawnKey);
-   printf("Recalculated hash: %016llX pawn: %016llX \n", TransTable.InitHashKey(p), TransTable.InitPawnKey(p));
-   printf("Piece/square eval: mg %d eg %d\n", p->pstMg[WHITE]-p->pstMg[BLACK], p->pstEg[WHITE]-p->pstEg[BLACK]);
+   printf("Incremental  hash: %016llX pawn: %016llX material: %016llX \n", p->hashKey, p->pawnKey, p->matKey);
+   printf("Recalculated hash: %016llX pawn: %016llX material: %016llX \n", TransTable.InitHashKey(p), TransTable.InitPawnKey(p), TransTable.InitMaterialKey(p));
+   printf("Piece/square eval: mg %d eg %d\n", MgScore(p->pst[WHITE]-p->pst[BLACK]), EgScore(p->pst[WHITE]-p->pst[BLACK]));
    printf("\n--------------------------------------------\n");
 }
@@ -103,30 +103,23 @@ void sData::InitPstValues(void)
   for (int sq = 0; sq < 64; sq++) {  
 	for (int side = 0; side < 2; side++) {
 
-	  pstMg[side][P][REL_SQ(sq,side)] = GetPawnMgPst(sq);
-	  pstMg[side][N][REL_SQ(sq,side)] = pstKnightMg[sq];
-	  pstMg[side][B][REL_SQ(sq,side)] = pstBishopMg[sq];
-	  pstMg[side][R][REL_SQ(sq,side)] = GetRookMgPst(sq); 
-	  pstMg[side][Q][REL_SQ(sq,side)] = -5 * (Rank(sq) == RANK_1); // 0 on remaining ranks
-	  pstMg[side][K][REL_SQ(sq,side)] = 10*(kingRank[Rank(sq)] + kingFile[File(sq)]);
-
-	  pstEg[side][P][REL_SQ(sq,side)] = 10 - neutral[File(sq)] - kingRank[Rank(sq)];
-	  pstEg[side][N][REL_SQ(sq,side)] = 5 * ( knightEg[Rank(sq)] + knightEg[File(sq)] );
-	  pstEg[side][B][REL_SQ(sq,side)] = 5 * ( neutral[Rank(sq)] + neutral[File(sq)] );
-	  pstEg[side][R][REL_SQ(sq,side)] = 0;
-	  pstEg[side][Q][REL_SQ(sq,side)] = 4 *  ( biased[Rank(sq)] + biased[File(sq)] ); 
-	  pstEg[side][K][REL_SQ(sq,side)] = 12 * ( biased[Rank(sq)] + biased[File(sq)] );
-
-	  pawnProperty[PHALANX]  [MG] [side] [REL_SQ(sq,side)] = GetPhalanxPstMg(sq);
-	  pawnProperty[PHALANX]  [EG] [side] [REL_SQ(sq,side)] = 0; // on modifying please uncomment relevant line in eval_pawns.c
-	  pawnProperty[PASSED]   [MG] [side] [REL_SQ(sq,side)] = passerMg * pawnAdv[Rank(sq)];
-	  pawnProperty[PASSED]   [EG] [side] [REL_SQ(sq,side)] = passerEg * pawnAdv[Rank(sq)];
-	  pawnProperty[CANDIDATE][MG] [side] [REL_SQ(sq,side)] = ( passerMg * pawnAdv[Rank(sq)] ) / 3;
-	  pawnProperty[CANDIDATE][EG] [side] [REL_SQ(sq,side)] = ( passerEg * pawnAdv[Rank(sq)] ) / 3;
-	  pawnProperty[ISOLATED] [MG] [side] [REL_SQ(sq,side)] = pawnIsolatedMg[File(sq)];
-	  pawnProperty[ISOLATED] [EG] [side] [REL_SQ(sq,side)] = pawnIsolatedEg[File(sq)];
-	  pawnProperty[BACKWARD] [MG] [side] [REL_SQ(sq,side)] = pawnBackwardMg[File(sq)];
-	  pawnProperty[BACKWARD] [EG] [side] [REL_SQ(sq,side)] = pawnBackwardEg[File(sq)];
+	  pst[side][P][REL_SQ(sq,side)] = MakeScore( GetPawnMgPst(sq),
+	                                             10 - neutral[File(sq)] - kingRank[Rank(sq)] );
+	  pst[side][N][REL_SQ(sq,side)] = MakeScore( pstKnightMg[sq],
+	                                             5 * ( knightEg[Rank(sq)] + knightEg[File(sq)] ) );
+	  pst[side][B][REL_SQ(sq,side)] = MakeScore( pstBishopMg[sq],
+	                                             5 * ( neutral[Rank(sq)] + neutral[File(sq)] ) );
+	  pst[side][R][REL_SQ(sq,side)] = MakeScore( GetRookMgPst(sq), 0 );
+	  pst[side][Q][REL_SQ(sq,side)] = MakeScore( -5 * (Rank(sq) == RANK_1), // 0 on remaining ranks
+	                                             4 * ( biased[Rank(sq)] + biased[File(sq)] ) );
+	  pst[side][K][REL_SQ(sq,side)] = MakeScore( 10 * ( kingRank[Rank(sq)] + kingFile[File(sq)] ),
+	                                             12 * ( biased[Rank(sq)] + biased[File(sq)] ) );
+
+	  pawnProperty[PHALANX]  [side] [REL_SQ(sq,side)] = MakeScore(GetPhalanxPstMg(sq), 0);
+	  pawnProperty[PASSED]   [side] [REL_SQ(sq,side)] = MakeScore(passerMg * pawnAdv[Rank(sq)], passerEg * pawnAdv[Rank(sq)]);
+	  pawnProperty[CANDIDATE][side] [REL_SQ(sq,side)] = MakeScore(( passerMg * pawnAdv[Rank(sq)] ) / 3, ( passerEg * pawnAdv[Rank(sq)] ) / 3);
+	  pawnProperty[ISOLATED] [side] [REL_SQ(sq,side)] = MakeScore(pawnIsolatedMg[File(sq)], pawnIsolatedEg[File(sq)]);
+	  pawnProperty[BACKWARD] [side] [REL_SQ(sq,side)] = MakeScore(pawnBackwardMg[File(sq)], pawnBackwardEg[File(sq)]);
 
 	  outpost[side][N][REL_SQ(sq,side)] = pstKnightOutpost[sq];
 	  outpost[side][B][REL_SQ(sq,side)] = pstBishopOutpost[sq];
@@ -2,6 +2,7 @@
 #include "bitboard/bb_fill.c"
 #include "bitboard/bb_init_masks.c"
 #include "bitboard/bb_init_mgen.c"
+#include "bitboard/bb_magic.c"
 #include "bitboard/bitboard.c"
 #include "search/blunder.c"
 #include "book.c"
@@ -17,6 +18,7 @@
 #include "bitboard/gencache.c"
 #include "hist.c"
 #include "init.c"
+#include "input.c"
 #include "learn.c"
 #include "move/legal.c"
 #include "main.c"
@@ -30,6 +32,7 @@
 #include "search/quiescence.c"
 #include "search/recognize.c"
 #include "search/search.c"
+#include "search/smp.c"
 #include "selector.c"
 #include "setboard.c"
 #include "swap.c"
@@ -29,14 +29,18 @@
    typedef unsigned long long U64;
    typedef unsigned long      U32;
    #define CDECL __cdecl
+   #define THREAD_LOCAL __declspec(thread)
 #else
    #include <stdint.h>
    #define llu_format  "%llu"
    typedef uint64_t U64;
    typedef uint32_t U32;
    #define CDECL
+   #define THREAD_LOCAL __thread
 #endif
 
+typedef unsigned char U8;
+
 #define MAX_INT 2147483646
 #define MAX_ELO 2600
 #define NO_PC 12
@@ -49,6 +53,14 @@ enum eRank  {RANK_1, RANK_2, RANK_3, RANK_4, RANK_5, RANK_6, RANK_7, RANK_8};
 enum eMoveType {NORMAL, CASTLE, EP_CAP, EP_SET, N_PROM, B_PROM, R_PROM, Q_PROM};
 enum eCastleFlag { W_KS = 1, W_QS = 2, B_KS = 4, B_QS = 8};
 enum eGamePhase {MG, EG};
+
+// Packed score: midgame value in the low 16 bits of an int, endgame value
+// in the high 16 bits, so that both are added or subtracted at once. Each
+// part must stay within 16 bits.
+
+#define MakeScore(mg, eg) ((int)((unsigned)(eg) << 16) + (mg))
+static inline int MgScore(int s) { return (short)(unsigned short)(unsigned)s; }
+static inline int EgScore(int s) { return (short)(unsigned short)((unsigned)(s + 0x8000) >> 16); }
 enum eHashEntry {NONE, UPPER, LOWER, EXACT};
 enum eProtocol {PROTO_UCI, PROTO_WB, PROTO_TXT};
 
@@ -91,6 +103,7 @@ enum eMoveFlag {
 #define MAX_EVAL        29999
 
 #define SIDE_RANDOM     (~((U64)0))
+#define ZOBRIST_SEED    1     // initial state of Random64(), recorded in saved hash files
 
 #define START_POS       "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"
 
@@ -110,7 +123,11 @@ enum eMoveFlag {
 #define Unmap0x88(x)    (((x) & 7) | (((x) & ~7) >> 1))
 #define Sq0x88Off(x)    ((unsigned)(x) & 0x88)
 
+#ifdef USE_ATTACK_MAPS
+#define InCheck(p)      ((p)->bbCheckers != 0)
+#else
 #define InCheck(p)      IsAttacked(p, KingSq(p, p->side), Opp(p->side))
+#endif
 #define IllegalPosition(p)  IsAttacked(p, KingSq(p, Opp(p->side)), p->side)
 
 #define bbPc(p, x, y)   ((p)->bbCl[x] & (p)->bbTp[y])
@@ -129,31 +146,88 @@ enum eMoveFlag {
 #define AHDAttacks(o, x) attacks[DIAG_AH][x][DiagIndex(o, x)]
 #define HADAttacks(o, x) attacks[DIAG_HA][x][AntiIndex(o, x)]
 
-#define RAttacks(o, x)  (HorAttacks(o, x) | VerAttacks(o, x))
-#define BAttacks(o, x)  (AHDAttacks(o, x) | HADAttacks(o, x))
+// kindergarten lookups, used to build the tables below and as a reference in "sliderbench"
+#define KgRAttacks(o, x) (HorAttacks(o, x) | VerAttacks(o, x))
+#define KgBAttacks(o, x) (AHDAttacks(o, x) | HADAttacks(o, x))
+
+// Slider attacks read from one table per square, indexed either by a fancy
+// magic multiplication or by the PEXT instruction. InitSliderAttacks() picks
+// the faster one at startup (see bitboard/bb_magic.c).
+
+#if defined(__x86_64__) || defined(_M_X64)
+   #define USE_PEXT // PEXT code is compiled in, but used only if the cpu supports it
+   #if defined(_MSC_VER)
+      #include <immintrin.h>
+      #define Pext(x, m) _pext_u64(x, m)
+   #else
+      static inline U64 Pext(U64 x, U64 m) { U64 r; __asm__("pextq %2, %1, %0" : "=r" (r) : "r" (x), "r" (m)); return r; }
+   #endif
+#endif
+
+enum eSliderBackend { SLIDERS_MAGIC, SLIDERS_PEXT };
+
+typedef struct {
+  U64 mask;            // squares whose occupancy matters (lines without their last square)
+  U64 magic;           // multiplier mapping masked occupancy to an index
+  U64 *table;          // attack sets of this square
+  int shift;           // 64 - number of bits in mask
+} sMagic;
+
+extern sMagic rookMagic[64];
+extern sMagic bishopMagic[64];
+extern int sliderBackend;
+
+static inline U64 SliderAttacks(const sMagic *m, U64 o)
+{
+#ifdef USE_PEXT
+  if (sliderBackend == SLIDERS_PEXT) return m->table[Pext(o, m->mask)];
+#endif
+  return m->table[((o & m->mask) * m->magic) >> m->shift];
+}
+
+#define RAttacks(o, x)  SliderAttacks(&rookMagic[x], o)
+#define BAttacks(o, x)  SliderAttacks(&bishopMagic[x], o)
 #define QAttacks(o, x)  (RAttacks(o, x)   | BAttacks(o, x))
 
+// Board representation, kept small (200 bytes) so that it fits in a few
+// cache lines and can be copied cheaply. Keys of earlier positions are
+// not part of it, they live on the repetition stack below.
+
 typedef struct         // board representation:
 {
   U64 bbCl[2];         // color bitboard
   U64 bbTp[6];         // piece type bitboard
-  int pcCount[2][6];   // count of pieces of a given color and type
+  U64 hashKey;
+  U64 pawnKey;
+  U64 matKey;          // material signature: depends only on the numbers of pieces
   int phase;           // incrementally calculated game phase
-  int pc[64];          // piece type on a given square
-  int kingSquare[2];   // king location for each side
   int pieceMat[2];     // non-pawn material for each side
-  int pstMg[2];        // incrementally updated midgame pst score
-  int pstEg[2];        // incrementally updated endgame pst score
-  int side;            // side to move
-  int castleFlags;     // castling flags
-  int epSquare;        // square where an en passant capture can be made (or invalid)
+  int pst[2];          // incrementally updated pst score (packed midgame/endgame)
   int reversibleMoves; // no. of reversible moves played in a row (not captures, not pawn moves)
-  int head;
-  U64 hashKey;
-  U64 pawnKey;
-  U64 repetitionList[256];
+  int head;            // number of keys on the repetition stack
+  U8  pc[64];          // piece type on a given square
+  U8  pcCount[2][6];   // count of pieces of a given color and type
+  U8  kingSquare[2];   // king location for each side
+  U8  side;            // side to move
+  U8  castleFlags;     // castling flags
+  U8  epSquare;        // square where an en passant capture can be made (or invalid)
+#ifdef USE_ATTACK_MAPS // attack maps kept up to date by DoMove/UndoMove (see attacks.c)
+  U64 bbAttFrom[64];   // squares attacked by a piece standing on a given square
+  U64 bbAttacks[2];    // squares attacked by each side
+  U64 bbPawnAtt[2];    // squares attacked by pawns of each side
+  U64 bbCheckers;      // enemy pieces giving check to the side to move
+#endif
 } sPosition;
 
+#define REP_STACK_SIZE 512 // game and search plies since the last irreversible move, with a wide margin
+
+typedef struct // hash keys of the positions that led to the current one, walked by IsRepetition()
+{
+  U64 keys[REP_STACK_SIZE]; // sPosition.head tells how many are in use
+} sRepStack;
+
+extern THREAD_LOCAL sRepStack RepStack;
+
 typedef struct  // set of move lists subdivided into move classes
 {
   sPosition *p;
@@ -162,11 +236,15 @@ typedef struct  // set of move lists subdivided into move classes
   int killer1;
   int killer2;
   int refutation;
-  int *next;
-  int *last;
-  int move[MAX_MOVES];
-  int value[MAX_MOVES];
-  int *badp;
+  U64 bbPinned;    // pieces of the side to move pinned to their king
+  U64 bbCheckers;  // enemy pieces giving check
+  U64 *next;       // next entry to return
+  U64 *last;
+  U64 *sorted;     // entries before this one are already in order
+  U64 list[MAX_MOVES]; // scored moves, packed with their sort values (see selector.c)
+  int move[MAX_MOVES]; // moves as they come from a generator
+  int *badp;       // end of bad captures saved for later
+  int *nextBad;
   int bad[MAX_MOVES];
 } MOVES;
 
@@ -175,9 +253,12 @@ struct sSelector // class that holds move lists and returns moves in predefined
 private:
 	MOVES m[1];  // move list
 	int MvvLva(sPosition *p, int move);
-	void ScoreCaptures(int hashMove);
-	void ScoreQuiet(int refutationSq);
+	void ScoreCaptures(int *last, int hashMove);
+	void ScoreQuiet(int *last, int refutationSq);
+	void ScoreEvasions(int *last, int refutationSq);
+	int NextEvasion(int refutationSq, int *flag);
 	int PickBestMove(void);
+	int IsLegalHere(int move);
 public:
 	int CaptureIsBad(sPosition *p, int move);
 	void InitCaptureList(sPosition *p, int hashMove);
@@ -191,6 +272,7 @@ typedef struct // move list without classification, but with scoring methods, us
   int moves[MAX_MOVES];
   int value[MAX_MOVES];
   int used[MAX_MOVES];
+  int excluded[MAX_MOVES]; // moves already shown as better lines in MultiPV mode
   int bestMove;
   int bestVal;
   int nOfMoves;
@@ -198,6 +280,8 @@ typedef struct // move list without classification, but with scoring methods, us
   void Init(sPosition *p);
   void AddMove(int move);
   void ClearUsed(int bestMove);
+  void ClearExcluded(void);
+  void Exclude(int move);
   void ScoreLastMove(int move, int val);
   int GetNextMove(void);
 } sFlatMoveList; // implemented in selector.c
@@ -210,6 +294,12 @@ typedef struct
   int reversibleMoves;
   U64 hashKey;
   U64 pawnKey;
+  U64 matKey;
+#ifdef USE_ATTACK_MAPS
+  U64 bbAttacks[2];
+  U64 bbPawnAtt[2];
+  U64 bbCheckers;
+#endif
 } UNDO;
 
 typedef struct 
@@ -225,11 +315,22 @@ extern sManipulator Manipulator;
 int IsAttacked(sPosition *p, int sq, int side);
 U64 AttacksFrom(sPosition *p, int sq);
 U64 AttacksTo(sPosition *p, int sq);
+#ifdef USE_ATTACK_MAPS
+void InitAttackMaps(sPosition *p);
+void UpdateAttackMaps(sPosition *p, U64 bbChanged);
+void SumAttackMaps(sPosition *p);
+#endif
 void BuildPv(int *dst, int *src, int move);
+int BestSliderBackend(void);
+void InitSliderAttacks(int backend);
+void BenchSliders(void);
 int *GenerateCaptures(sPosition *p, int *list);
 int *GenerateQuiet(sPosition *p, int *list);
+int *GenerateEvasions(sPosition *p, int *list, U64 bbCheckers);
+U64 GetCheckers(sPosition *p);
+U64 GetPinned(sPosition *p);
+int LeavesKingSafe(sPosition *p, int move, U64 bbPinned, U64 bbCheckers);
 void Init(void);
-int InputAvailable(void);
 int IsLegal(sPosition *p, int move);
 void MoveToStr(int move, char *moveString);
 void PrintMove(int move);
@@ -238,6 +339,7 @@ U64 Random64(void);
 void SetPosition(sPosition *p, char *epd);
 int StrToMove(sPosition *p, char *moveString);
 int Swap(sPosition *p, int from, int to);
+int SeeGe(sPosition *p, int move, int threshold);
 U64 atoull(const char *s);
 
 extern U64 bbPawnSupport[2][64];
@@ -265,6 +367,7 @@ extern const int bitTable[64];
 extern U64 zobPiece[12][64];
 extern U64 zobCastle[16];
 extern U64 zobEp[8];
-extern int pondering;
+extern volatile int pondering;
+extern volatile int stopSearch;  // set by the input thread or the watchdog, polled by search
 extern char ponder_str[6];
 extern int flagProtocol;
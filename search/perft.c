@@ -18,17 +18,44 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <algorithm>
 #include "../rodent.h"
 #include "../trans.h"
 #include "../hist.h"
 #include "../timer.h"
+#include "../eval/eval.h"
 #include "search.h"
 
-void sSearcher::Bench(int depth)
+// with more than one thread, bench is run twice (single-threaded and
+// with all threads), and time-to-depth speedup is reported
+
+void sSearcher::Bench(int depth, int threads)
+{
+	int oldThreads = Smp.GetThreads();
+
+	if (threads <= 1) {
+		BenchRun(depth);
+		return;
+	}
+
+	Smp.SetThreads(1);
+	int singleTime = BenchRun(depth);
+	Smp.SetThreads(threads);
+	int smpTime = BenchRun(depth);
+	Smp.SetThreads(oldThreads);
+
+	printf("Time to depth %d: %d ms with 1 thread, %d ms with %d threads, speedup %.2f\n",
+	        depth, singleTime, smpTime, threads, (float)singleTime / (float)Max(1, smpTime) );
+}
+
+int sSearcher::BenchRun(int depth)
 {
 	sPosition p[1];
 	int pv[MAX_PLY];
+	U64 helperNodes = 0;
 	char *test[] =  {
 		"r1bqkbnr/pp1ppppp/2n5/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq -",
 		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
@@ -49,26 +76,38 @@ void sSearcher::Bench(int depth)
 		NULL
 	}; // test positions taken from DiscoCheck by Lucas Braesch
 
-	printf("Bench test started (depth %d): \n", depth);
+	printf("Bench test started (depth %d, threads %d): \n", depth, Smp.GetThreads() );
+#ifdef USE_ATTACK_MAPS
+	printf("Attack maps: incremental\n");
+#else
+	printf("Attack maps: on demand\n");
+#endif
 	Timer.Clear();
 	Timer.SetData(MAX_DEPTH, depth );
 	Timer.SetStartTime();
 	ClearStats();
+	isReporting = 1;
+	threadId = 0;
 
 	for (int i = 0; test[i]; ++i) {
 		TransTable.Clear();
+		QsTable.Clear();
+		EvalTable.Clear();
 		History.OnNewGame();
 		printf(test[i]);
 		SetPosition(p, test[i]);
 		printf("\n");
 		if (flagProtocol == PROTO_TXT) PrintTxtHeader();
 		Iterate(p, pv);
+		helperNodes += Smp.GetNodes() - nodes; // helpers reset their counters on each search
 	}
 
 	int endTime = Timer.GetElapsedTime();
-	U32 nps  = GetNps(nodes, endTime);
-	printf("%d nodes searched in %d, speed %u nps (Score: %.3f)\n", nodes, endTime, nps, (float)nps/430914.0);
+	U64 totalNodes = nodes + helperNodes;
+	U32 nps  = GetNps(totalNodes, endTime);
+	printf(llu_format " nodes searched in %d, speed %u nps (Score: %.3f)\n", totalNodes, endTime, nps, (float)nps/430914.0);
 	DisplayStats();
+	return endTime;
 }
 
 int sSearcher::Perft(sPosition *p, int ply, int depth) 
@@ -84,15 +123,11 @@ int sSearcher::Perft(sPosition *p, int ply, int depth)
 
     while ( move = Selector.NextMove(refutationSq, &flagMoveType) ) {
 
-	   Manipulator.DoMove(p, move, undoData);    
-	
-	   if (IllegalPosition(p)) { 
-		   Manipulator.UndoMove(p, move, undoData); 
-		   continue; 
-	   }
+       // selector returns legal moves only, so at the last ply we just count them
+       if (depth == 1) { nOfMoves++; continue; }
 
-       if (depth == 1) nOfMoves++;
-	   else            nOfMoves += Perft(p, ply+1, depth-1);
+	   Manipulator.DoMove(p, move, undoData);    
+	   nOfMoves += Perft(p, ply+1, depth-1);
 	   Manipulator.UndoMove(p, move, undoData);
   }
 
@@ -121,11 +156,6 @@ void sSearcher::Divide(sPosition *p, int ply, int depth)
     while ( move = Selector.NextMove(refutationSq, &flagMoveType) ) {
 	
 	   Manipulator.DoMove(p, move, undoData);    
-	
-	   if (IllegalPosition(p)) { 
-		   Manipulator.UndoMove(p, move, undoData); 
-		   continue; 
-	   }
 
        if (depth == 1) nOfMoves++;
 	   else  {   
@@ -141,3 +171,227 @@ void sSearcher::Divide(sPosition *p, int ply, int depth)
 	printf("total: %d\n", nOfMoves);
 	printf("%d \n", Timer.GetElapsedTime() ); 
 }
+
+// Collects hash and pawn keys of all positions in a perft tree
+// (keys[0] gets hash keys, keys[1] pawn keys).
+
+void sSearcher::CollectKeys(sPosition *p, int ply, int depth, U64 **keys, int *cnt, int *size)
+{
+	UNDO  undoData[1];  // data required to undo a move
+	sSelector Selector;
+	int move = 0;
+	int flagMoveType;
+
+	if (*cnt == *size) {
+		*size *= 2;
+		keys[0] = (U64 *) realloc(keys[0], *size * sizeof(U64));
+		keys[1] = (U64 *) realloc(keys[1], *size * sizeof(U64));
+	}
+	keys[0][*cnt] = p->hashKey;
+	keys[1][*cnt] = p->pawnKey;
+	(*cnt)++;
+	if (depth == 0) return;
+
+    Selector.InitMoveList(p, 0, 0, move, ply);
+
+    while ( move = Selector.NextMove(0, &flagMoveType) ) {
+
+	   Manipulator.DoMove(p, move, undoData);    
+	   CollectKeys(p, ply+1, depth-1, keys, cnt, size);
+	   Manipulator.UndoMove(p, move, undoData);
+  }
+}
+
+// Prints how n distinct keys are spread among slots of a table, compared
+// with what a perfectly random hash function would give (Poisson
+// distribution of slot loads).
+
+static void PrintDistribution(const char *name, U64 *keys, int n, U64 nOfSlots, int isMultiplyShift)
+{
+	U64 maxSlots = 1 << 22;            // larger tables are simulated with fewer slots
+	U64 slots = Min(nOfSlots, maxSlots);
+	int *load = (int *) calloc((size_t)slots, sizeof(int));
+	int hist[6] = {0};
+	double lambda = (double)n / slots;
+	double chi2 = 0;
+
+	for (int i = 0; i < n; i++) {
+		U64 slot = isMultiplyShift ? TtBucketIndex(keys[i], slots) : keys[i] % slots;
+		load[slot]++;
+	}
+
+	for (U64 i = 0; i < slots; i++) {
+		hist[Min(load[i], 5)]++;
+		chi2 += (load[i] - lambda) * (load[i] - lambda);
+	}
+	chi2 /= lambda * (slots - 1); // about 1.0 for uniformly spread keys
+
+	printf("%s: " llu_format " slots%s, %d keys, load %.3f, chi2/df %.3f\n", name, slots,
+	        slots < nOfSlots ? " (simulated)" : "", n, lambda, chi2);
+	printf("   slot load  :      0      1      2      3      4     5+\n");
+	printf("   actual   %%  :");
+	for (int i = 0; i < 6; i++) printf(" %6.2f", 100.0 * hist[i] / slots);
+	printf("\n   expected %%  :");
+	double prob = exp(-lambda), rest = 1.0;
+	for (int i = 0; i < 5; i++) {
+		printf(" %6.2f", 100.0 * prob);
+		rest -= prob;
+		prob *= lambda / (i + 1);
+	}
+	printf(" %6.2f\n", 100.0 * rest);
+	free(load);
+}
+
+// counts pairs of distinct keys sharing the same 32 lowest or highest bits;
+// a good generator gives about n^2 / 2^33 of each
+
+static void PrintPartialCollisions(U64 *keys, int n)
+{
+	U64 *part = (U64 *) malloc(n * sizeof(U64));
+	int same[2] = {0, 0};
+
+	for (int half = 0; half < 2; half++) {
+		for (int i = 0; i < n; i++)
+			part[i] = half ? keys[i] >> 32 : keys[i] & 0xffffffff;
+		std::sort(part, part + n);
+		for (int i = 1; i < n; i++)
+			if (part[i] == part[i - 1]) same[half]++;
+	}
+	printf("   32-bit collisions: low half %d, high half %d, expected %.1f\n",
+	        same[0], same[1], (double)n * n / 8589934592.0);
+	free(part);
+}
+
+// "keystats <depth>" checks quality of Zobrist keys on positions from
+// a perft tree of the current position: how evenly they load transposition
+// table buckets and pawn hash slots, and how often partial keys collide
+
+void sSearcher::KeyStats(sPosition *p, int depth)
+{
+	U64 *keys[2];
+	int cnt = 0, size = 1 << 16;
+	int unique[2];
+
+	keys[0] = (U64 *) malloc(size * sizeof(U64));
+	keys[1] = (U64 *) malloc(size * sizeof(U64));
+	CollectKeys(p, 0, Max(depth, 1), keys, &cnt, &size);
+
+	for (int i = 0; i < 2; i++) {
+		std::sort(keys[i], keys[i] + cnt);
+		unique[i] = (int)(std::unique(keys[i], keys[i] + cnt) - keys[i]);
+	}
+
+	printf("Positions visited: %d, distinct hash keys: %d, distinct pawn keys: %d\n", cnt, unique[0], unique[1]);
+	PrintDistribution("Transposition table buckets", keys[0], unique[0], TransTable.BucketCount(), 1);
+	PrintPartialCollisions(keys[0], unique[0]);
+	PrintDistribution("Pawn hash slots", keys[1], unique[1], Eval.PawnTableSize(), 1);
+
+	free(keys[0]);
+	free(keys[1]);
+}
+
+// "seebench <depth>" checks SeeGe() against Swap() on captures from positions
+// of a perft tree of the current position, then times both of them
+
+#define SEE_POSITIONS 4096
+#define SEE_ROUNDS    64
+
+typedef struct {
+	int pos;
+	int move;
+} sSeeCase;
+
+void sSearcher::CollectPositions(sPosition *p, int ply, int depth, sPosition *store, int *cnt)
+{
+	UNDO  undoData[1];  // data required to undo a move
+	sSelector Selector;
+	int move = 0;
+	int flagMoveType;
+
+	if (*cnt == SEE_POSITIONS) return;
+	store[(*cnt)++] = *p;
+	if (depth == 0) return;
+
+    Selector.InitMoveList(p, 0, 0, move, ply);
+
+    while ( move = Selector.NextMove(0, &flagMoveType) ) {
+	   Manipulator.DoMove(p, move, undoData);    
+	   CollectPositions(p, ply+1, depth-1, store, cnt);
+	   Manipulator.UndoMove(p, move, undoData);
+  }
+}
+
+void sSearcher::SeeBench(sPosition *p, int depth)
+{
+	const int threshold[3] = {-100, 0, 100};
+	sPosition *store = (sPosition *) malloc(SEE_POSITIONS * sizeof(sPosition));
+	sSeeCase *cases  = (sSeeCase *) malloc(SEE_POSITIONS * MAX_MOVES * sizeof(sSeeCase));
+	int list[MAX_MOVES], *last;
+	int nOfPos = 0, nOfCases = 0, errors = 0, sum[2] = {0, 0};
+
+	CollectPositions(p, 0, Max(depth, 1), store, &nOfPos);
+	for (int i = 0; i < nOfPos; i++) {
+		last = GenerateCaptures(&store[i], list);
+		for (int *movep = list; movep < last; movep++) {
+			cases[nOfCases].pos  = i;
+			cases[nOfCases++].move = *movep;
+		}
+	}
+
+	for (int i = 0; i < nOfCases; i++) {
+		sPosition *pos = &store[cases[i].pos];
+		int move = cases[i].move;
+		for (int j = 0; j < 3; j++)
+			if ((Swap(pos, Fsq(move), Tsq(move)) >= threshold[j]) != SeeGe(pos, move, threshold[j]))
+				errors++;
+	}
+
+	int start = Timer.GetMS();
+	for (int r = 0; r < SEE_ROUNDS; r++)
+		for (int i = 0; i < nOfCases; i++)
+			sum[0] += Swap(&store[cases[i].pos], Fsq(cases[i].move), Tsq(cases[i].move)) >= 0;
+	int swapTime = Timer.GetMS() - start;
+
+	start = Timer.GetMS();
+	for (int r = 0; r < SEE_ROUNDS; r++)
+		for (int i = 0; i < nOfCases; i++)
+			sum[1] += SeeGe(&store[cases[i].pos], cases[i].move, 0);
+	int seeGeTime = Timer.GetMS() - start;
+
+	double calls = (double)nOfCases * SEE_ROUNDS;
+	printf("Positions: %d, captures: %d, disagreements: %d\n", nOfPos, nOfCases, errors);
+	printf("Swap() >= 0 : %5d ms, %6.1f ns per call (%d passed)\n", swapTime, swapTime * 1e6 / calls, sum[0]);
+	printf("SeeGe(0)    : %5d ms, %6.1f ns per call (%d passed)\n", seeGeTime, seeGeTime * 1e6 / calls, sum[1]);
+
+	free(cases);
+	free(store);
+}
+
+// Times full evaluation of positions collected from the tree. The eval cache
+// is switched off meanwhile, so that every call does the whole work; the sum
+// of scores tells whether two builds evaluate the same way.
+
+#define EVAL_ROUNDS 256
+
+void sSearcher::EvalBench(sPosition *p, int depth)
+{
+	sPosition *store = (sPosition *) malloc(SEE_POSITIONS * sizeof(sPosition));
+	int nOfPos = 0, evalMb = EvalTable.GetSizeMb();
+	long long sum = 0;
+
+	CollectPositions(p, 0, Max(depth, 1), store, &nOfPos);
+	EvalTable.Alloc(0);
+	Eval.ClearMaterialTable();
+
+	int start = Timer.GetMS();
+	for (int r = 0; r < EVAL_ROUNDS; r++)
+		for (int i = 0; i < nOfPos; i++)
+			sum += Eval.ReturnFull(&store[i], -INF, INF);
+	int evalTime = Timer.GetMS() - start;
+
+	EvalTable.Alloc(evalMb);
+	printf("Positions: %d, ReturnFull(): %5d ms, %6.1f ns per call (checksum %lld)\n",
+		nOfPos, evalTime, evalTime * 1e6 / ((double)nOfPos * EVAL_ROUNDS), sum);
+
+	free(store);
+}
@@ -29,16 +29,24 @@
 int sSearcher::Quiesce(sPosition *p, int ply, int qDepth, int alpha, int beta, int isRoot, int *pv)
 {
   int best, score, move = 0, newPv[MAX_PLY];
+  int exactEval;
   sSelector Selector;
   UNDO undoData[1];
+  PROBE tt[1];
 
   nodes++;
   IncStat(Q_NODES);
   CheckInput();
 
   // TRANSPOSITION TABLE READ
-  if (TransTable.Retrieve(p->hashKey, &move, &score, alpha, beta, 1, ply))
-  return score;
+  QsTable.Probe(p->hashKey, tt);
+  IncStat(QT_PROBE);
+  if (tt->found) IncStat(QT_HIT);
+  move = QsTable.GetMove(tt);
+  if (QsTable.Retrieve(tt, &score, alpha, beta, ply)) {
+     IncStat(QT_CUTOFF);
+     return score;
+  }
   
   // EARLY EXIT CONDITIONS
   if (flagAbortSearch) return 0;
@@ -51,12 +59,16 @@ int sSearcher::Quiesce(sPosition *p, int ply, int qDepth, int alpha, int beta, i
   // safeguard against hitting max ply limit
   if (ply >= MAX_PLY - 1) return Eval.ReturnFull(p, alpha, beta);
 
-  best = Eval.ReturnFull(p, alpha, beta);
+  // static eval is taken from quiescence hash table if possible
+  exactEval = QsTable.GetEval(tt);
+  if (exactEval != INVALID) best = exactEval;
+  else {
+     best = Eval.ReturnFull(p, alpha, beta);
+     if (Eval.isExact) exactEval = best;
+  }
 
   if (best >= beta) { 
-  // CAUSES DIFFERENT NODE COUNTS BETWEEN DEBUG AND RELEASE COMPILE 
-  // - probably there's an uninitialized variable in sEvaluator or setboard
-  //  TransTable.Store(p->hashKey, 0, score, LOWER, 1, ply);
+	  QsTable.Store(tt, 0, best, LOWER, ply, exactEval);
 	  return best;
   }
 
@@ -76,12 +88,6 @@ int sSearcher::Quiesce(sPosition *p, int ply, int qDepth, int alpha, int beta, i
 	 
     Manipulator.DoMove(p, move, undoData);
     
-	// don't process illegal moves
-	if (IllegalPosition(p)) { 
-		Manipulator.UndoMove(p, move, undoData); 
-		continue; 
-	}
-    
 	score = -Quiesce(p, ply+1, qDepth+1, -beta, -alpha, 0, newPv);
     Manipulator.UndoMove(p, move, undoData);
 
@@ -89,7 +95,7 @@ int sSearcher::Quiesce(sPosition *p, int ply, int qDepth, int alpha, int beta, i
 
 	// BETA CUTOFF
 	if (score >= beta) {
-	   TransTable.Store(p->hashKey, move, score, LOWER, 1, ply);
+	   QsTable.Store(tt, move, score, LOWER, ply, exactEval);
 	   return score;
 	}
 
@@ -104,8 +110,8 @@ int sSearcher::Quiesce(sPosition *p, int ply, int qDepth, int alpha, int beta, i
   }
 
   // SAVE SEARCH RESULT IN TRANSPOSITION TABLE
-  if (*pv) TransTable.Store(p->hashKey, *pv, best, EXACT, 1, ply);
-  else     TransTable.Store(p->hashKey,   0, best, UPPER, 1, ply);
+  if (*pv) QsTable.Store(tt, *pv, best, EXACT, ply, exactEval);
+  else     QsTable.Store(tt,   0, best, UPPER, ply, exactEval);
 
   return best;
 }
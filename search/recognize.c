@@ -20,33 +20,29 @@
 #include "../rodent.h"
 #include "../bitboard/bitboard.h"
 #include "search.h"
+#include "../eval/eval.h"
 
 int KPKdraw(sPosition *p, int stronger);
 
 int sSearcher::RecognizeDraw(sPosition *p) 
 {
-  if ( p->pcCount[WHITE][P] == 0 && p->pcCount[BLACK][P] == 0 ) {		  
+  switch (Eval.ProbeMaterial(p)->drawCode) {
 
-	  if ( p->pieceMat[WHITE] + p->pieceMat[BLACK] < 400 ) {
-	     if ( !IllegalPosition(p) ) return 1;
-	  }  // bare kings or Km vs K 
-	   
-	  if (p->pieceMat[WHITE] < 400 
-	  &&  p->pieceMat[BLACK] < 400
-	  &&  (bbPc(p, WHITE, K) & bbRim) == 0
-	  &&  (bbPc(p, BLACK, K) & bbRim) == 0 ) {
-		  if ( !IllegalPosition(p) ) return 1;
-	  }   // Km vs Km; just in case we ensure that neither king is on the rim 
-  } // no pawns
+  case DRAW_BARE:   // bare kings or Km vs K 
+     return !IllegalPosition(p);
 
-  if (p->pieceMat[WHITE] == 0 && p->pieceMat[BLACK] == 0) {
+  case DRAW_MINORS: // Km vs Km; just in case we ensure that neither king is on the rim 
+     if ( (bbPc(p, WHITE, K) & bbRim) == 0
+     &&   (bbPc(p, BLACK, K) & bbRim) == 0 ) 
+        return !IllegalPosition(p);
+     return 0;
 
-	  if (p->pcCount[WHITE][P] == 1 && p->pcCount[BLACK][P] == 0) 
-	     return KPKdraw(p, WHITE); // exactly one white pawn
+  case DRAW_KPK_WHITE: // exactly one white pawn
+     return KPKdraw(p, WHITE);
 
-	  if (p->pcCount[BLACK][P] == 1 && p->pcCount[WHITE][P] == 0)
-         return KPKdraw(p, BLACK); // exactly one black pawn
-  } // pawns only
+  case DRAW_KPK_BLACK: // exactly one black pawn
+     return KPKdraw(p, BLACK);
+  }
 
   return 0;
 }
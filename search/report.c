@@ -21,6 +21,7 @@
 #include "../rodent.h"
 #include "../data.h"
 #include "../timer.h"
+#include "../trans.h"
 #include "search.h"
 
 void sSearcher::ClearStats(void) {
@@ -38,6 +39,33 @@ void sSearcher::DisplayStats(void)
 	 printf("Quiescence ratio: %d percent \n", (stat[Q_NODES   ] * 100) / Max(1, nodes) );
 }
 
+U64 sSearcher::GetStat(int slot) {
+	return stat[slot];
+}
+
+// transposition table statistics of the last search, summed over all threads
+
+void sSearcher::DisplayTtStats(void)
+{
+	 U64 probes = Max(Smp.GetStat(TT_PROBE), (U64)1);
+	 U64 hits   = Smp.GetStat(TT_HIT);
+	 U64 stores = Max(Smp.GetStat(TT_STORE_SAME)  + Smp.GetStat(TT_STORE_EMPTY)
+	                + Smp.GetStat(TT_STORE_OLD)   + Smp.GetStat(TT_STORE_SHALLOWER)
+	                + Smp.GetStat(TT_STORE_DEEPER), (U64)1);
+
+	 TransTable.DisplayOccupancy();
+	 printf("Probes   : " llu_format ", hits %.1f%%, misses %.1f%%, cutoffs %.1f%%\n", probes,
+	         100.0 * hits / probes, 100.0 * (probes - hits) / probes, 100.0 * Smp.GetStat(TT_CUTOFF) / probes);
+	 printf("Stores   : " llu_format ", same position %.1f%%, empty %.1f%%, older search %.1f%%, shallower %.1f%%, deeper %.1f%%\n", stores,
+	         100.0 * Smp.GetStat(TT_STORE_SAME) / stores, 100.0 * Smp.GetStat(TT_STORE_EMPTY) / stores,
+	         100.0 * Smp.GetStat(TT_STORE_OLD) / stores,  100.0 * Smp.GetStat(TT_STORE_SHALLOWER) / stores,
+	         100.0 * Smp.GetStat(TT_STORE_DEEPER) / stores);
+
+	 U64 qProbes = Max(Smp.GetStat(QT_PROBE), (U64)1);
+	 printf("Qsearch  : " llu_format " probes, hits %.1f%%, cutoffs %.1f%%\n", qProbes,
+	         100.0 * Smp.GetStat(QT_HIT) / qProbes, 100.0 * Smp.GetStat(QT_CUTOFF) / qProbes);
+}
+
 void sSearcher::DisplayRootInfo(void) 
 {
    if (Data.verbose && rootDepth / ONE_PLY > 6) {
@@ -72,7 +100,8 @@ void sSearcher::DisplayPv(int score, int *pv)
 
   char *type, pv_str[512];
   int time = Timer.GetElapsedTime();
-  U32 nps  = GetNps(nodes, time);
+  U64 totalNodes = Smp.GetNodes(); // nodes searched by all threads
+  U32 nps  = GetNps(totalNodes, time);
 
   type = "mate";
   if (score < -MAX_EVAL)
@@ -84,13 +113,19 @@ void sSearcher::DisplayPv(int score, int *pv)
   
   PvToStr(pv, pv_str);
 
-  if (flagProtocol == PROTO_UCI)
-  printf("info depth %d time %d nodes %u nps %d score %s %d pv %s\n",
-          rootDepth/ONE_PLY, time,   nodes,   nps,   type, score, pv_str);
-
-  if (flagProtocol == PROTO_TXT)
-  printf("%2d. %3d.%1d %10u %4d %4d %s\n",
-          rootDepth/ONE_PLY, time/1000, (time/100)%10, nodes, nodes / (time+1),  score, pv_str);
+  if (flagProtocol == PROTO_UCI) {
+  char multipv_str[32] = "";
+  if (multiPv > 1) sprintf(multipv_str, " multipv %d", pvIndex + 1);
+  printf("info%s depth %d time %d nodes " llu_format " nps %d hashfull %d score %s %d pv %s\n",
+          multipv_str, rootDepth/ONE_PLY, time, totalNodes, nps, TransTable.HashFull(), type, score, pv_str);
+  }
+
+  if (flagProtocol == PROTO_TXT) {
+  char nodes_str[32];
+  sprintf(nodes_str, llu_format, totalNodes);
+  printf("%2d. %3d.%1d %10s %4d %4d %s\n",
+          rootDepth/ONE_PLY, time/1000, (time/100)%10, nodes_str, (int)(totalNodes / (time+1)),  score, pv_str);
+  }
 }
 
 void sSearcher::DisplaySavedIterationTime(void) {
@@ -100,16 +135,17 @@ void sSearcher::DisplaySavedIterationTime(void) {
 void sSearcher::DisplaySpeed(void) 
 {
     int time = Timer.GetElapsedTime();
-    U32 nps  = GetNps(nodes, time);
+    U64 totalNodes = Smp.GetNodes();
+    U32 nps  = GetNps(totalNodes, time);
 
-    printf("info time %d nodes %u nps %d \n",
-                 time,   nodes,   nps );
+    printf("info time %d nodes " llu_format " nps %d \n",
+                 time,   totalNodes,   nps );
 }
 
-U32 sSearcher::GetNps(int nodes, int time) 
+U32 sSearcher::GetNps(U64 nodes, int time) 
 {
     U64 uTime  = (U64)time;
-	U64 uNodes = (U64)nodes;
+	U64 uNodes = nodes;
 
     if (uTime == 0) return 0;
 
@@ -74,11 +74,20 @@ void sSearcher::Think(sPosition *p, int *pv)
    bestMove = 0;
    int flagBookProblem = 0;
    isReporting         = 1;
+   threadId            = 0;
    nodes               = 0;
    flagAbortSearch     = 0;
    History.OnNewSearch();
+   Eval.AllocPawnTable(Data.pawnHash);
+   Eval.ClearMaterialTable();
    TransTable.ChangeDate();
+   if (TransTable.GetDate() == 0) { // the date has wrapped around
+      TransTable.ClearEvals();
+      QsTable.Clear();
+      EvalTable.Clear();
+   }
    Timer.SetStartTime();
+   Timer.StartWatchdog();
    ClearStats();
    pv[0] = 0; // for tests where book move is disabled
    if (Data.useBook) 
@@ -90,65 +99,83 @@ void sSearcher::Think(sPosition *p, int *pv)
       if (Data.panelStyle == PANEL_NORMAL) DisplaySettings();
    }
 
+   Timer.StopWatchdog();
    DisplayStats();
 }
 
+// entry point for helper threads of lazy smp (see smp.c)
+
+void sSearcher::HelperThink(sPosition *p, int id)
+{
+   int pv[MAX_PLY];
+
+   nodesPerBranch  = 0;
+   bestMove        = 0;
+   isReporting     = 0;
+   threadId        = id;
+   ClearStats();
+   flagAbortSearch = 0;
+   History.OnNewSearch();
+   Eval.AllocPawnTable(Data.pawnHash);
+   Eval.ClearMaterialTable();
+   Iterate(p, pv);
+}
+
+int sSearcher::GetNodes(void)
+{
+   return nodes;
+}
+
 void sSearcher::Iterate(sPosition *p, int *pv) 
 {
    int val = 0;
-   int curVal, alpha, beta, delta;
+   int curVal;
    rootSide = p->side;
-   Data.InitAsymmetric(p->side);          // set asymmetric eval parameters, dependent on the side to move
+
+   if (isReporting) {
+      Data.InitAsymmetric(p->side);       // set asymmetric eval parameters, dependent on the side to move
+      Smp.StartHelpers(p);                // helper threads start searching the same position
+   }
+
    rootList.Init(p);                      // create sorted root move list (using quiescence search scores)
+   pvIndex = 0;
+   multiPv = isReporting ? Min(Data.multiPv, rootList.nOfMoves) : 1;
+   if (multiPv < 1) multiPv = 1;
+   for (int i = 0; i < multiPv; i++) {
+      multiPvScore[i] = 0;
+      multiPvLine[i][0] = 0;
+   }
    int localDepth = Timer.GetData(MAX_DEPTH) * ONE_PLY;
    if (rootList.nOfMoves == 1) localDepth = 4 * ONE_PLY; // single reply
-   Timer.SetIterationTiming();            // define additional rules for starting next iteration
-   Timer.SetData(FLAG_ROOT_FAIL_LOW, 0);  // we haven't failed low yet
-
-   // check whether of the moves is potentially easy
-   Timer.SetData(FLAG_EASY_MOVE,     1);
-   for(int i = 0; i < rootList.nOfMoves; i ++) {
-      if (rootList.moves[i] != rootList.bestMove
-      && rootList.value[i] > rootList.bestVal - 220) {
-         Timer.SetData(FLAG_EASY_MOVE,     0);
-         break;
+
+   if (isReporting) {
+      Timer.SetIterationTiming();            // define additional rules for starting next iteration
+      Timer.SetData(FLAG_ROOT_FAIL_LOW, 0);  // we haven't failed low yet
+
+      // check whether of the moves is potentially easy
+      Timer.SetData(FLAG_EASY_MOVE,     1);
+      for(int i = 0; i < rootList.nOfMoves; i ++) {
+         if (rootList.moves[i] != rootList.bestMove
+         && rootList.value[i] > rootList.bestVal - 220) {
+            Timer.SetData(FLAG_EASY_MOVE,     0);
+            break;
+         }
       }
    }
 
-   for (rootDepth = ONE_PLY; rootDepth <= localDepth; rootDepth+=ONE_PLY) {
+   // every other helper thread starts one ply deeper, so that threads
+   // do not search the same iteration in lockstep
+   for (rootDepth = ONE_PLY + (threadId & 1) * ONE_PLY; rootDepth <= localDepth; rootDepth+=ONE_PLY) {
 
       DisplayRootInfo();
-      delta = aspiration;
 
-      if (rootDepth <= 6 * ONE_PLY) { alpha = -INF;      beta = INF;       }
-      else                          { alpha = val-delta; beta = val+delta; }
-    
-      // first use aspiration window around the value from the last completed depth
-      curVal = SearchRoot(p, alpha, beta, rootDepth, pv);
-      bestMove = pv[0];
+      if (multiPv == 1) curVal = AspirationSearch(p, val, pv);
+      else              curVal = SearchMultiPv(p, pv);
       if (flagAbortSearch) break;
 
-      // if score is outside the window, re-search
-      if (curVal >= beta || curVal <= alpha) {
-
-         // fail-low, it might be prudent to assign some more time
-         if (curVal < val) Timer.OnRootFailLow();
-         if (curVal >= beta)  beta  = val +3*delta;
-         if (curVal <= alpha) alpha = val -3*delta;
-
-         curVal = SearchRoot(p, alpha, beta, rootDepth, pv);
-         bestMove = pv[0];
-         if (flagAbortSearch) break;
-
-         // the second window
-         if (curVal >= beta || curVal <= alpha) 
-            curVal = SearchRoot(p, -INF, INF, rootDepth, pv);
-            bestMove = pv[0];
-            if (flagAbortSearch) break;
-      }
-
       // SAVE POSITION LEARNING DATA
       if (Data.useLearning 
+      &&  isReporting
       && !flagAbortSearch
       && !Data.useWeakening
       &&  p->pieceMat[WHITE] > 2000 
@@ -156,7 +183,7 @@ void sSearcher::Iterate(sPosition *p, int *pv)
          Learner.WriteLearnData(p->hashKey, rootDepth, curVal);
 
       // abort root search if we don't expect to finish the next iteration
-      if (Timer.FinishIteration() ) {
+      if (isReporting && Timer.FinishIteration() ) {
          if (Data.verbose) {
             DisplaySavedIterationTime();
             if (Timer.GetData(FLAG_EASY_MOVE) ) printf("info string This iteration was easy!\n");
@@ -166,6 +193,99 @@ void sSearcher::Iterate(sPosition *p, int *pv)
 
       val = curVal;
    }
+
+   if (isReporting) Smp.StopHelpers();
+}
+
+// searches the root using aspiration window around the value from the last completed depth
+
+int sSearcher::AspirationSearch(sPosition *p, int val, int *pv)
+{
+   int curVal, alpha, beta;
+   int delta = aspiration;
+
+   if (rootDepth <= 6 * ONE_PLY) { alpha = -INF;      beta = INF;       }
+   else                          { alpha = val-delta; beta = val+delta; }
+
+   // first use aspiration window
+   curVal = SearchRoot(p, alpha, beta, rootDepth, pv);
+   bestMove = pv[0];
+   if (flagAbortSearch) return 0;
+
+   // if score is outside the window, re-search
+   if (curVal >= beta || curVal <= alpha) {
+
+      // fail-low, it might be prudent to assign some more time
+      if (curVal < val && isReporting && pvIndex == 0) Timer.OnRootFailLow();
+      if (curVal >= beta)  beta  = val +3*delta;
+      if (curVal <= alpha) alpha = val -3*delta;
+
+      curVal = SearchRoot(p, alpha, beta, rootDepth, pv);
+      bestMove = pv[0];
+      if (flagAbortSearch) return 0;
+
+      // the second window
+      if (curVal >= beta || curVal <= alpha) 
+         curVal = SearchRoot(p, -INF, INF, rootDepth, pv);
+      bestMove = pv[0];
+   }
+   return curVal;
+}
+
+// MultiPV: the best line is searched first, then its first move is excluded
+// from the root move list and the search is repeated to get the second best
+// line, and so on. Each line uses an aspiration window around its own score
+// from the previous iteration. Later lines are much cheaper than the first
+// one, as they are searched with the hash table and history filled by it.
+
+int sSearcher::SearchMultiPv(sPosition *p, int *pv)
+{
+   int i, j, tmp;
+   int order[MAX_PV];
+
+   rootList.ClearExcluded();
+   for (pvIndex = 0; pvIndex < multiPv; pvIndex++) {
+      int *line = multiPvLine[pvIndex];
+      int score = AspirationSearch(p, multiPvScore[pvIndex], line);
+      if (flagAbortSearch) break;
+      multiPvScore[pvIndex] = score;
+      rootList.Exclude(line[0]);
+   }
+
+   rootList.ClearExcluded();
+
+   // on abort, results of the best line are still valid if it has been completed
+   if (flagAbortSearch && pvIndex == 0) {
+      pvIndex = 0;
+      return 0;
+   }
+
+   // sort completed lines by score (stable, so that ties keep the search order)
+   int nOfLines = pvIndex;
+   for (i = 0; i < nOfLines; i++) order[i] = i;
+   for (i = 1; i < nOfLines; i++)
+      for (j = i; j > 0 && multiPvScore[order[j]] > multiPvScore[order[j-1]]; j--) {
+         tmp = order[j]; order[j] = order[j-1]; order[j-1] = tmp;
+      }
+
+   int sortedScore[MAX_PV], sortedLine[MAX_PV][MAX_PLY];
+   for (i = 0; i < nOfLines; i++) {
+      sortedScore[i] = multiPvScore[order[i]];
+      memcpy(sortedLine[i], multiPvLine[order[i]], sizeof(sortedLine[i]));
+   }
+   for (i = 0; i < nOfLines; i++) {
+      multiPvScore[i] = sortedScore[i];
+      memcpy(multiPvLine[i], sortedLine[i], sizeof(multiPvLine[i]));
+   }
+
+   if (!flagAbortSearch) 
+      for (pvIndex = 0; pvIndex < nOfLines; pvIndex++)
+         DisplayPv(multiPvScore[pvIndex], multiPvLine[pvIndex]);
+
+   pvIndex = 0;
+   memcpy(pv, multiPvLine[0], sizeof(multiPvLine[0]));
+   bestMove = pv[0];
+   return multiPvScore[0];
 }
 
 int sSearcher::SearchRoot(sPosition *p, int alpha, int beta, int depth, int *pv)
@@ -183,9 +303,13 @@ int sSearcher::SearchRoot(sPosition *p, int alpha, int beta, int depth, int *pv)
   int movesTried     = 0;       // count of moves that initiated new searches
   int flagInCheck    = InCheck(p); // are we in check at the beginning of the search?
 
+  // in MultiPV mode only the best line talks to the timer and prints its pv;
+  // other lines are printed by SearchMultiPv() once they are sorted
+  int isMainLine     = (isReporting && pvIndex == 0);
+
   // at root we keep track whether a move has been found; if not, we let the engine
   // search for a bit longer, as this might indicate a fail-high/fail-low
-  Timer.SetData(FLAG_NO_FIRST_MOVE, 1);
+  if (isMainLine) Timer.SetData(FLAG_NO_FIRST_MOVE, 1);
 
   // CHECK EXTENSION (no QS entry later as SearchRoot is called with depth >= 1 ply)
   if (flagInCheck) depth += ONE_PLY;
@@ -228,7 +352,7 @@ int sSearcher::SearchRoot(sPosition *p, int alpha, int beta, int depth, int *pv)
 	 nodesPerBranch = 0;
 	
 	 movesTried++;    // increase legal move count
-	 if (Data.verbose && !pondering && depth > 6 * ONE_PLY) DisplayCurrmove(move, movesTried);
+	 if (Data.verbose && isReporting && !pondering && depth > 6 * ONE_PLY) DisplayCurrmove(move, movesTried);
 	 depthChange = 0; // no depth modification so far
 	 History.OnMoveTried(move);
 
@@ -248,17 +372,17 @@ int sSearcher::SearchRoot(sPosition *p, int alpha, int beta, int depth, int *pv)
      Manipulator.UndoMove(p, move, undoData);
 	 rootList.ScoreLastMove(move, nodesPerBranch);
 
-	 Timer.SetData(FLAG_NO_FIRST_MOVE, 0);
+	 if (isMainLine) Timer.SetData(FLAG_NO_FIRST_MOVE, 0);
 
 	 if (flagAbortSearch) return 0; // timeout, "stop" command or mispredicted ponder move
 
      // BETA CUTOFF
 	 if (score >= beta) {
-		 if (movesTried > 1 && depth > 2*ONE_PLY) Timer.SetData(FLAG_EASY_MOVE, 0);
+		 if (movesTried > 1 && depth > 2*ONE_PLY && isMainLine) Timer.SetData(FLAG_EASY_MOVE, 0);
 		 IncStat(FAIL_HIGH);
 		 if (movesTried == 1) IncStat(FAIL_FIRST);
          History.OnGoodMove(p, 0, move, depth / ONE_PLY, 0);
-         TransTable.Store(p->hashKey, move, score, LOWER, depth, 0);
+         if (pvIndex == 0) TransTable.Store(p->hashKey, move, score, LOWER, depth, 0, INVALID);
          return score;
      }
 
@@ -266,11 +390,11 @@ int sSearcher::SearchRoot(sPosition *p, int alpha, int beta, int depth, int *pv)
      if (score > best) {
          best = score;
 		 if (best != -INF) scoreChange++;
-		 if (movesTried > 1 && depth > 2*ONE_PLY) Timer.SetData(FLAG_EASY_MOVE, 0);
+		 if (movesTried > 1 && depth > 2*ONE_PLY && isMainLine) Timer.SetData(FLAG_EASY_MOVE, 0);
          if (score > alpha) {
             alpha = score;
             BuildPv(pv, newPv, move);
-		    DisplayPv(score, pv);
+		    if (isMainLine) DisplayPv(score, pv);
          }
       }
    }
@@ -279,14 +403,17 @@ int sSearcher::SearchRoot(sPosition *p, int alpha, int beta, int depth, int *pv)
    if (best == -INF) return flagInCheck ? -MATE : 0;
 
    // SAVE SEARCH RESULT IN TRANSPOSITION TABLE
+   // (in MultiPV mode only the best line, as other lines exclude some root moves)
    if (*pv) {
  	 History.OnGoodMove(p, 0, *pv, depth / ONE_PLY, 0);
-     TransTable.Store(p->hashKey, *pv, best, EXACT, depth, 0);
-   } else
-     TransTable.Store(p->hashKey, 0, best, UPPER, depth, 0);
+     if (pvIndex == 0) TransTable.Store(p->hashKey, *pv, best, EXACT, depth, 0, INVALID);
+   } else if (pvIndex == 0)
+     TransTable.Store(p->hashKey, 0, best, UPPER, depth, 0, INVALID);
 
-   if (!scoreChange) Timer.OnOldRootMove();
-   else              Timer.OnNewRootMove();
+   if (isMainLine) {
+      if (!scoreChange) Timer.OnOldRootMove();
+      else              Timer.OnNewRootMove();
+   }
    return best;
 }
 
@@ -301,6 +428,7 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
       flagMoveType;             // move type flag, supplied by NextMove()
   sSelector Selector;           // an object responsible for maintaining move list and picking moves 
     UNDO  undoData[1];          // data required to undo a move
+  PROBE tt[1];                  // result of transposition table probe, reused throughout the node
 
   // NODE INITIALIZATION
   int nullScore      = 0;       // result of a null move search
@@ -310,6 +438,7 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
   int blunderCount   = 0;       // forces the engine to try one of the top moves in weakening mode
   int nodeEval       = INVALID; // we have not called evaluation function at this node yet 
   int fullNodeEval   = INVALID;
+  int exactEval      = INVALID; // full (not lazy) static eval, to be saved in transposition table
   int flagIsReduced  = 0;       // are we in a reduced search? (guides re-searches)
   int flagFutility   = 0;       // can we apply futility pruning in this node
   int flagInCheck    = InCheck(p); // are we in check at the beginning of the search?
@@ -349,12 +478,21 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
   if (alpha >= beta) return alpha;
 
   // TRANSPOSITION TABLE READ
-  if (TransTable.Retrieve(p->hashKey, &move, &score, alpha, beta, depth, ply)) 
+  TransTable.Probe(p->hashKey, tt);
+  IncStat(TT_PROBE);
+  if (tt->found) IncStat(TT_HIT);
+  move = TransTable.GetMove(tt);
+  if (TransTable.Retrieve(tt, &score, alpha, beta, depth, ply)) 
   {
+     IncStat(TT_CUTOFF);
      if (score >= beta)
         History.UpdateSortOnly(p, move, depth / ONE_PLY, ply);
      return score;
   }
+
+  // STATIC EVAL SAVED IN TRANSPOSITION TABLE
+  exactEval = TransTable.GetEval(tt);
+  if (exactEval != INVALID) nodeEval = fullNodeEval = exactEval;
   
   // SAFEGUARD AGAINST HITTING MAX PLY LIMIT
   if (ply >= MAX_PLY - 1) return Eval.ReturnFull(p, alpha, beta);
@@ -398,14 +536,17 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
   &&  !wasNull
   &&   p->pieceMat[p->side] > Data.matValue[N]) 
   {
-    fullNodeEval = Eval.ReturnFull(p, alpha, beta);
+    if (fullNodeEval == INVALID) {
+       fullNodeEval = Eval.ReturnFull(p, alpha, beta);
+       if (Eval.isExact) exactEval = fullNodeEval;
+    }
     if ( beta <= fullNodeEval ) {
 
       newDepth = nullDepth[depth];
 	  int verDepth = newDepth - 2 * ONE_PLY;
 
 	  // normal search would fail low, so null move search shouldn't fail high
-      if (TransTable.Retrieve(p->hashKey, &nullRefutation, &nullScore, alpha, beta, newDepth, ply) ) {
+      if (TransTable.Retrieve(tt, &nullScore, alpha, beta, newDepth, ply) ) {
 		  if (nullScore <= alpha) goto avoidNull;
 	  }
 		  
@@ -414,7 +555,7 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
 
 	  // extract refutation of a null move from transposition table; usually 
 	  // it will be a capture and we will sort safe evasions above other quiet moves.
-	  TransTable.Retrieve(p->hashKey, &nullRefutation, &score, alpha, beta, depth, ply);
+	  TransTable.RetrieveMove(p->hashKey, &nullRefutation);
 	  
 	  // get target square of null move refutation to sort escape moves a bit higher
 	  if (nullRefutation != 0 ) refutationSq = Tsq(nullRefutation);
@@ -423,8 +564,10 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
       if (flagAbortSearch) return 0; // timeout, "stop" command or mispredicted ponder move
 
 	  // verify null move
-	  if (nullScore >= beta && depth >= 8 * ONE_PLY ) 
+	  if (nullScore >= beta && depth >= 8 * ONE_PLY ) {
           nullScore = Search(p, ply, alpha, beta, verDepth, CUT_NODE, NO_NULL, lastMove, newPv);
+		  TransTable.Probe(p->hashKey, tt); // verification search has stored this position
+	  }
 	                                             
       if (nullScore >= beta)
 		 return Eval.Normalize(nullScore, MAX_EVAL); // checkmate from null move search isn't reliable
@@ -441,7 +584,10 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
    &&  !(bbPc(p,p->side,P) & bbRelRank[p->side][RANK_7] ) // no pawns to promote in one move
    &&   depth <= 3*ONE_PLY) {
       int threshold = beta - 300 - (depth-ONE_PLY) * 15;
-	  if (fullNodeEval == INVALID) fullNodeEval = Eval.ReturnFull(p, alpha, beta);
+	  if (fullNodeEval == INVALID) {
+	     fullNodeEval = Eval.ReturnFull(p, alpha, beta);
+	     if (Eval.isExact) exactEval = fullNodeEval;
+	  }
 
       if (fullNodeEval < threshold) {
 		 score = Quiesce(p, ply, 0, alpha, beta, 0, pv); 
@@ -452,12 +598,14 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
   // INTERNAL ITERATIVE DEEPENING - we try to get a hash move to improve move ordering
   if (nodeType == PV_NODE && !move && depth >= 4*ONE_PLY && !flagInCheck ) {
 	  Search(p, ply, alpha, beta, depth-2*ONE_PLY, PV_NODE, NO_NULL, lastMove, newPv); 
-	  TransTable.RetrieveMove(p->hashKey, &move);
+	  TransTable.Probe(p->hashKey, tt);
+	  move = TransTable.GetMove(tt);
   }
 
   if (nodeType == CUT_NODE && !move && depth >= 6*ONE_PLY && !flagInCheck ) {
 	  Search(p, ply, alpha, beta, depth-4*ONE_PLY, PV_NODE, NO_NULL, lastMove, newPv);
-	  TransTable.RetrieveMove(p->hashKey, &move);
+	  TransTable.Probe(p->hashKey, tt);
+	  move = TransTable.GetMove(tt);
   } // end of internal iterative deepening code
 
   // CREATE MOVE LIST AND START SEARCHING
@@ -475,7 +623,7 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
             && flagCanPrune
             && alpha > -MAX_EVAL ) {
                if (nodeEval == INVALID) nodeEval = Eval.ReturnFast(p);
-               nodeEval = TransTable.RefineScore( p->hashKey, nodeEval );
+               nodeEval = TransTable.RefineScore( tt, nodeEval );
 
                // this node looks bad enough, so we may apply futility pruning
                if ( (nodeEval + futilityMargin[depth] ) < beta ) flagFutility = 1;
@@ -486,12 +634,6 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
 
 	 // MAKE A MOVE
 	 Manipulator.DoMove(p, move, undoData);    
-	
-	 // UNDO ILLEGAL MOVES
-	 if (IllegalPosition(p)) { 
-	 	 Manipulator.UndoMove(p, move, undoData); 
-		 continue; 
-	 }
 
      // MAKE RANDOM BLUNDERS IN WEAKENING MODE
      if (Blunder(p, ply, depth, flagMoveType, move, lastMove, flagInCheck)
@@ -594,7 +736,7 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
 		 if (!History.MoveChangesMaterialBalance(p, move) ) {
 		    History.UpdateRefutation(lastMove, move);
 		 }		    
-         TransTable.Store(p->hashKey, move, score, LOWER, depth, ply);
+         IncStat(TT_STORE_SAME + TransTable.Store(tt, move, score, LOWER, depth, ply, exactEval));
          return score;
      }
 
@@ -614,9 +756,9 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
    // SAVE SEARCH RESULT IN TRANSPOSITION TABLE
    if (*pv) {
  	 History.OnGoodMove(p, lastMove, *pv, depth / ONE_PLY, ply);
-     TransTable.Store(p->hashKey, *pv, best, EXACT, depth, ply);
+     IncStat(TT_STORE_SAME + TransTable.Store(tt, *pv, best, EXACT, depth, ply, exactEval));
    } else
-     TransTable.Store(p->hashKey, 0, best, UPPER, depth, ply);
+     IncStat(TT_STORE_SAME + TransTable.Store(tt, 0, best, UPPER, depth, ply, exactEval));
 
    return best;
 }
@@ -624,7 +766,7 @@ int sSearcher::Search(sPosition *p, int ply, int alpha, int beta, int depth, int
 int sSearcher::IsRepetition(sPosition *p)
 {
    for (int i = 4; i <= p->reversibleMoves; i += 2)
-      if (p->hashKey == p->repetitionList[p->head - i])
+      if (p->hashKey == RepStack.keys[p->head - i])
          return 1;
    return 0;
 }
@@ -641,33 +783,30 @@ int sSearcher::AvoidReduction(int move, int flagMoveType) {
    return (MoveType(move) != CASTLE) && (flagMoveType != FLAG_HASH_MOVE) && (flagMoveType != FLAG_KILLER_MOVE);
 }
 
+// input and clock are watched by other threads (see input.c and sTimer::WatchdogLoop),
+// here we only pick up their stop signal
+
 void sSearcher::CheckInput(void)
 {
-   char command[80];
+   // helper threads don't read input and don't watch the clock
+   if (!isReporting) {
+      if (Smp.HelpersMustStop()) flagAbortSearch = 1;
+      return;
+   }
 
    if (Data.verbose) {
       if (!( nodes % 500000) ) DisplaySpeed(); // report search speed
    }
 
-   if (nodes & 4095 || rootDepth == ONE_PLY) return;
+   if (rootDepth == ONE_PLY) return;    // make sure we have some move
 
-   if (InputAvailable()) {
-      Parser.ReadLine(command, sizeof(command));
-      if (strcmp(command, "stop") == 0)
-         flagAbortSearch = 1;
-      else if (strcmp(command, "ponderhit") == 0)
-         pondering = 0;
-   }
+   // "stop", "quit" or timeout
+   if (stopSearch) flagAbortSearch = 1;
 
    // node limit exceeded
-   if ( Timer.GetData(MAX_NODES) 
-   && nodes > Timer.GetData(MAX_NODES)) 
-      flagAbortSearch = 1;
-
-   // timeout
-   if ( !pondering 
-   && !Timer.IsInfiniteMode()
-   && Timer.TimeHasElapsed() )
+   if ( !(nodes & 4095)
+   && Timer.GetData(MAX_NODES) 
+   && Smp.GetNodes() > (U64)Timer.GetData(MAX_NODES)) 
       flagAbortSearch = 1;
 }
 
@@ -27,14 +27,23 @@
 #define WAS_NULL  1
 #define NO_NULL   0
 
-enum eStatEntries { FAIL_HIGH, FAIL_FIRST, Q_NODES, END_OF_STATS};
+#define MAX_THREADS 64
+#define MAX_PV      64
+
+// TT_STORE_SAME..TT_STORE_DEEPER follow the order of eTtReplace
+enum eStatEntries { FAIL_HIGH, FAIL_FIRST, Q_NODES, 
+                    TT_PROBE, TT_HIT, TT_CUTOFF, 
+                    TT_STORE_SAME, TT_STORE_EMPTY, TT_STORE_OLD, TT_STORE_SHALLOWER, TT_STORE_DEEPER, 
+                    QT_PROBE, QT_HIT, QT_CUTOFF, 
+                    END_OF_STATS};
 
 struct sSearcher {
 private:
 	int rootSide;
 	int flagAbortSearch;
 	void CheckInput(void);
-	int isReporting;
+	int isReporting;      // main thread reports and manages time, helper threads just fill the hash table
+	int threadId;
 	int aspiration;       // initial size of aspiration window
     int futilityDepth;
 	int futilityMargin[10*ONE_PLY];
@@ -54,7 +63,7 @@ private:
 	void DisplaySavedIterationTime();
 	void DisplaySpeed(void);
 	void PrintTxtHeader(void);
-	U32  GetNps(int nodes, int time);
+	U32  GetNps(U64 nodes, int time);
 
 	// search.c
 	int nodesPerBranch;
@@ -64,7 +73,16 @@ private:
 	int IsMoveOrdinary(int flagMoveType);
 	int AvoidReduction(int move, int flagMoveType);
 	int Perft(sPosition *p, int ply, int depth);
+	void CollectKeys(sPosition *p, int ply, int depth, U64 **keys, int *cnt, int *size);
+	void CollectPositions(sPosition *p, int ply, int depth, sPosition *store, int *cnt);
 	int SearchRoot(sPosition *p, int alpha, int beta, int depth, int *pv);
+	int AspirationSearch(sPosition *p, int val, int *pv);
+	int SearchMultiPv(sPosition *p, int *pv);
+	int multiPv;                        // number of lines searched at the root
+	int pvIndex;                        // line being searched now (0 = best line)
+	int multiPvScore[MAX_PV];
+	int multiPvLine[MAX_PV][MAX_PLY];
+	int BenchRun(int depth);
 	
 	int RecognizeDraw(sPosition *p);
 	int nodes;
@@ -80,10 +98,42 @@ public:
 	int DrawScore(sPosition *p);
 	int Quiesce(sPosition *p, int ply, int qDepth, int alpha, int beta, int isRoot, int *pv);
 	void Think(sPosition *, int *);
+	void HelperThink(sPosition *p, int id);
+	int GetNodes(void);
+	U64 GetStat(int slot);
+	void DisplayTtStats(void);
 	void ShowPerft(sPosition *p, int depth);
 	void Divide(sPosition *p, int ply, int depth);
-	void Bench(int depth);
+	void KeyStats(sPosition *p, int depth);
+	void SeeBench(sPosition *p, int depth);
+	void EvalBench(sPosition *p, int depth);
+	void Bench(int depth, int threads);
 	int Search(sPosition *p, int ply, int alpha, int beta, int depth, int nodeType, int wasNull, int lastMove, int *pv);
 };
 
-extern struct sSearcher Searcher;
+extern THREAD_LOCAL struct sSearcher Searcher;
+
+struct sSmp {  // lazy smp: helper threads searching the same position, sharing only the hash table
+private:
+	volatile int flagStop;              // tells helpers to abandon current search
+	volatile int flagQuit;              // tells helpers to exit
+	volatile int isBusy[MAX_THREADS];   // set by the main thread to start a helper, cleared by a helper when it is done
+	sSearcher * volatile searcher[MAX_THREADS]; // per-thread searchers, used to collect node counts
+	sPosition rootPos;
+	sRepStack rootKeys;                 // keys of positions played before rootPos
+	int nOfThreads;
+	void StartThread(int id);
+	void JoinThreads(void);
+public:
+	void Init(void);
+	void SetThreads(int cnt);
+	int  GetThreads(void);
+	void StartHelpers(sPosition *p);
+	void StopHelpers(void);
+	void HelperLoop(int id);
+	int  HelpersMustStop(void);
+	U64  GetNodes(void);
+	U64  GetStat(int slot);
+}; // implemented in smp.c
+
+extern sSmp Smp;
@@ -0,0 +1,173 @@
+/*
+  Rodent, a UCI chess playing engine derived from Sungorus 1.4
+  Copyright (C) 2009-2011 Pablo Vazquez (Sungorus author)
+  Copyright (C) 2011-2014 Pawel Koziol
+
+  Rodent is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation, either version 3 of the License,
+  or (at your option) any later version.
+
+  Rodent is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Lazy SMP. Helper threads search the same root position as the main
+thread, each using its own instances of sSearcher, sHistory, sEvaluator,
+sGenCache and sRepStack (they are declared THREAD_LOCAL), the last one
+copied from the main thread with the root position. The only thing threads
+share is the transposition table, so helpers speed up the main thread
+by filling it with useful entries. Only the main thread reads input,
+manages time and prints search information.
+*/
+
+#if defined(_WIN32) || defined(_WIN64)
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+#include "../rodent.h"
+#include "../bitboard/gencache.h"
+#include "../hist.h"
+#include "search.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+static HANDLE threadHandle[MAX_THREADS];
+static DWORD WINAPI HelperEntry(LPVOID arg) { Smp.HelperLoop((int)(size_t)arg); return 0; }
+#  define SmpSleep()   Sleep(1)
+#  define SmpBarrier() MemoryBarrier()
+#else
+static pthread_t threadHandle[MAX_THREADS];
+static void *HelperEntry(void *arg) { Smp.HelperLoop((int)(size_t)arg); return NULL; }
+#  define SmpSleep()   usleep(1000)
+#  define SmpBarrier() __sync_synchronize()
+#endif
+
+void sSmp::Init(void)
+{
+  nOfThreads = 1;
+  flagStop   = 0;
+  flagQuit   = 0;
+  for (int i = 0; i < MAX_THREADS; i++) {
+    isBusy[i]   = 0;
+    searcher[i] = NULL;
+  }
+  searcher[0] = &Searcher; // main thread
+}
+
+void sSmp::StartThread(int id)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  threadHandle[id] = CreateThread(NULL, 0, HelperEntry, (LPVOID)(size_t)id, 0, NULL);
+#else
+  pthread_create(&threadHandle[id], NULL, HelperEntry, (void *)(size_t)id);
+#endif
+}
+
+void sSmp::JoinThreads(void)
+{
+  flagQuit = 1;
+  for (int i = 1; i < nOfThreads; i++) {
+#if defined(_WIN32) || defined(_WIN64)
+    WaitForSingleObject(threadHandle[i], INFINITE);
+    CloseHandle(threadHandle[i]);
+#else
+    pthread_join(threadHandle[i], NULL);
+#endif
+    searcher[i] = NULL;
+  }
+  flagQuit = 0;
+}
+
+void sSmp::SetThreads(int cnt)
+{
+  if (cnt < 1) cnt = 1;
+  if (cnt > MAX_THREADS) cnt = MAX_THREADS;
+  if (cnt == nOfThreads) return;
+
+  JoinThreads();
+  nOfThreads = cnt;
+  for (int i = 1; i < nOfThreads; i++)
+    StartThread(i);
+}
+
+int sSmp::GetThreads(void)
+{
+  return nOfThreads;
+}
+
+// called by the main thread when it starts iterative deepening
+
+void sSmp::StartHelpers(sPosition *p)
+{
+  if (nOfThreads == 1) return;
+
+  rootPos = *p;
+  rootKeys = RepStack;
+  flagStop = 0;
+  SmpBarrier();
+  for (int i = 1; i < nOfThreads; i++)
+    isBusy[i] = 1;  // this wakes helpers up
+}
+
+// called by the main thread once it has finished searching
+
+void sSmp::StopHelpers(void)
+{
+  if (nOfThreads == 1) return;
+
+  flagStop = 1;
+  for (int i = 1; i < nOfThreads; i++)
+    while (isBusy[i]) SmpSleep();
+}
+
+void sSmp::HelperLoop(int id)
+{
+  sPosition p[1];
+
+  GenCache.Init();
+  Searcher.Init();
+  History.OnNewGame();
+  searcher[id] = &Searcher;
+
+  for (;;) {
+    while (!isBusy[id] && !flagQuit) SmpSleep();
+    if (flagQuit) return;
+    SmpBarrier();
+
+    *p = rootPos;
+    RepStack = rootKeys;
+    Searcher.HelperThink(p, id);
+    isBusy[id] = 0;
+  }
+}
+
+// true when the main thread wants helpers to abandon their search
+
+int sSmp::HelpersMustStop(void)
+{
+  return flagStop || flagQuit;
+}
+
+U64 sSmp::GetNodes(void)
+{
+  U64 total = 0;
+  for (int i = 0; i < nOfThreads; i++)
+    if (searcher[i]) total += searcher[i]->GetNodes();
+  return total;
+}
+
+U64 sSmp::GetStat(int slot)
+{
+  U64 total = 0;
+  for (int i = 0; i < nOfThreads; i++)
+    if (searcher[i]) total += searcher[i]->GetStat(slot);
+  return total;
+}
@@ -31,6 +31,26 @@ and sorting of moves.
 #include "trans.h"
 #include "hist.h"
 
+// sort value bands used for check evasions, which are kept in a single list
+#define EVADE_GOOD_CAPT  400000
+#define EVADE_KILLER     200000
+#define EVADE_BAD_CAPT  -200000
+
+// A scored move is packed into a single entry: sort value (made unsigned 
+// by a bias) in the upper half, position in the generated list (counted 
+// from the end) in bits 16-23 and the move itself in the lowest 16 bits.
+// No two entries are equal, so taking the largest one each time gives the
+// order of a stable sort by value, whatever way we get there.
+
+#define SORT_BIAS          0x40000000
+#define Entry(val, i, move) (((U64)((val) + SORT_BIAS) << 32) | ((U64)(MAX_MOVES - 1 - (i)) << 16) | (U64)(move))
+#define EntryMove(e)       ((int)((e) & 0xFFFF))
+#define EntryValue(e)      ((int)((e) >> 32) - SORT_BIAS)
+
+// Quiet moves with this value or less (no history at all) are not sorted
+// in advance; PickBestMove() looks for them only if search gets that far.
+#define QUIET_SORT_LIMIT   0
+
 // initializes data needed for move ordering
 void sSelector::InitMoveList(sPosition *p, int refMove, int contMove, int transMove, int ply)
 {
@@ -40,33 +60,42 @@ void sSelector::InitMoveList(sPosition *p, int refMove, int contMove, int transM
   m->refutation = refMove;
   m->killer1 = History.GetKiller(ply, 0);
   m->killer2 = History.GetKiller(ply, 1);
+  m->bbPinned   = GetPinned(p);
+  m->bbCheckers = GetCheckers(p);
+}
+
+// moves are generated pseudo-legal, but selector returns only legal ones
+
+int sSelector::IsLegalHere(int move)
+{
+  return LeavesKingSafe(m->p, move, m->bbPinned, m->bbCheckers);
 }
 
 int sSelector::NextMove(int refutationSq, int *flag)
 {
   int move;
 
+  if (m->bbCheckers) return NextEvasion(refutationSq, flag);
+
   switch (m->phase) {
 
   case 0: // first return transposition table move, if legal
     move = m->transMove;
-    if (move && IsLegal(m->p, move)) {
+    if (move && IsLegal(m->p, move) && IsLegalHere(move)) {
       m->phase = 1;
 	  *flag = FLAG_HASH_MOVE;
       return move;
     }
 
   case 1: // helper phase: capture generation
-    m->last = GenerateCaptures(m->p, m->move);
-    ScoreCaptures(0);
-    m->next = m->move;
+    ScoreCaptures(GenerateCaptures(m->p, m->move), 0);
     m->badp = m->bad;
     m->phase = 2;
 
   case 2: // return good or equal captures
     while (m->next < m->last) {
       move = PickBestMove();
-      if (move == m->transMove) continue; // hash move already tried
+      if (!IsLegalHere(move)) continue;
 
       // save bad captures for later
 	  if (CaptureIsBad(m->p, move) ) {
@@ -81,7 +110,8 @@ int sSelector::NextMove(int refutationSq, int *flag)
     move = m->killer1;
     if (move && move != m->transMove 
     &&  m->p->pc[Tsq(move)] == NO_PC 
-	&& IsLegal(m->p, move)) 
+	&& IsLegal(m->p, move)
+	&& IsLegalHere(move)) 
 	{
       m->phase = 4;
 	  *flag = FLAG_KILLER_MOVE;
@@ -92,50 +122,98 @@ int sSelector::NextMove(int refutationSq, int *flag)
     move = m->killer2;
     if (move && move != m->transMove 
 	&&  m->p->pc[Tsq(move)] == NO_PC 
-	&& IsLegal(m->p, move)) {
+	&& IsLegal(m->p, move)
+	&& IsLegalHere(move)) {
       m->phase = 5;
 	  *flag = FLAG_KILLER_MOVE;
       return move;
     }
 
   case 5: // helper phase: generate quiet moves
-    m->last = GenerateQuiet(m->p, m->move);
-    ScoreQuiet(refutationSq);
-    m->next = m->move;
+    ScoreQuiet(GenerateQuiet(m->p, m->move), refutationSq);
     m->phase = 6;
 
   case 6: // return next quiet move
     while (m->next < m->last) {
       move = PickBestMove();
-
-      if (move == m->transMove 
-      ||  move == m->killer1 
-	  ||  move == m->killer2)
-        continue;
+      if (!IsLegalHere(move)) continue;
 
 	  if ( Fsq(move) == refutationSq)   *flag = FLAG_NULL_EVASION;
 	  else                              *flag = FLAG_NORMAL_MOVE;
 
       return move;
     }
-    m->next = m->bad;
+    m->nextBad = m->bad;
     m->phase = 7;
 
   case 7: // return next bad capture
-	  if (m->next < m->badp) {
+	  if (m->nextBad < m->badp) {
       *flag = FLAG_BAD_CAPTURE; 
-      return *m->next++;
+      return *m->nextBad++;
 	  }
   }
   return 0;
 }
 
+// In check we generate only moves that might resolve it. They are returned
+// in the same order as moves of a normal node: hash move, good captures, 
+// killers, quiet moves and bad captures.
+
+int sSelector::NextEvasion(int refutationSq, int *flag)
+{
+  int move;
+
+  switch (m->phase) {
+
+  case 0: // transposition table move, if legal
+    move = m->transMove;
+    if (move && IsLegal(m->p, move) && IsLegalHere(move)) {
+      m->phase = 1;
+	  *flag = FLAG_HASH_MOVE;
+      return move;
+    }
+
+  case 1: // helper phase: evasion generation
+    ScoreEvasions(GenerateEvasions(m->p, m->move, m->bbCheckers), refutationSq);
+    m->phase = 2;
+
+  case 2: // return evasions
+    while (m->next < m->last) {
+      move = PickBestMove();
+      if (!IsLegalHere(move)) continue;
+
+      int val = EntryValue(m->next[-1]);
+      if      (val >= EVADE_GOOD_CAPT)    *flag = FLAG_GOOD_CAPTURE;
+      else if (val >= EVADE_KILLER)       *flag = FLAG_KILLER_MOVE;
+      else if (val < 0)                   *flag = FLAG_BAD_CAPTURE;
+      else if (Fsq(move) == refutationSq) *flag = FLAG_NULL_EVASION;
+      else                                *flag = FLAG_NORMAL_MOVE;
+      return move;
+    }
+  }
+  return 0;
+}
+
 void sSelector::InitCaptureList(sPosition *p, int hashMove)
 {
+  int *last;
+
   m->p = p;
-  m->last = GenerateCaptures(m->p, m->move);
-  ScoreCaptures(hashMove);
-  m->next = m->move;
+  m->transMove  = 0;
+  m->bbPinned   = GetPinned(p);
+  m->bbCheckers = GetCheckers(p);
+
+  // in check only captures of the checker and king captures can be legal, 
+  // so they are picked from the evasion list
+  if (m->bbCheckers) {
+    int *movep, *evasionEnd = GenerateEvasions(m->p, m->move, m->bbCheckers);
+    last = m->move;
+    for (movep = m->move; movep < evasionEnd; movep++)
+      if (History.MoveChangesMaterialBalance(p, *movep))
+        *last++ = *movep;
+  } else
+    last = GenerateCaptures(m->p, m->move);
+  ScoreCaptures(last, hashMove);
 }
 
 int sSelector::NextCapture(void)  // used in Quiesce()
@@ -144,20 +222,50 @@ int sSelector::NextCapture(void)  // used in Quiesce()
 
   while (m->next < m->last) {
     move = PickBestMove();
-    return move;
+    if (IsLegalHere(move)) return move;
   }
   return 0;
 }
 
+// Inserts entries greater than or equal to the limit at the front of the
+// list, in descending order, and returns the end of that sorted part. The
+// entries left behind are all smaller, so they can be picked later by
+// a plain search for the maximum.
+
+static U64 *SortAbove(U64 *first, U64 *last, U64 limit)
+{
+  U64 *sortedEnd = first;
+
+  for (U64 *e = first; e < last; e++) {
+    if (*e >= limit) {
+      U64 entry = *e, *q;
+      *e = *sortedEnd;
+      for (q = sortedEnd++; q > first && *(q - 1) < entry; q--)
+        *q = *(q - 1);
+      *q = entry;
+    }
+  }
+  return sortedEnd;
+}
+
+// Scoring functions fill m->list with moves from m->move, skipping those
+// already returned by earlier stages (hash move, killers) or never needed.
+// Captures and evasions are few, so they are sorted at once.
+
 // order captures using MvvLva() function and putting hash move first
 
-void sSelector::ScoreCaptures(int hashMove)
+void sSelector::ScoreCaptures(int *last, int hashMove)
 {
-  int *movep, *valuep;
+  U64 *entry = m->list;
 
-  valuep = m->value;
-  for (movep = m->move; movep < m->last; movep++)
-    *valuep++ = (MvvLva(m->p, *movep) + (1000 * (*movep == hashMove) ) );
+  for (int i = 0; m->move + i < last; i++) {
+    int move = m->move[i];
+    if (move == m->transMove) continue; // hash move already tried
+    *entry++ = Entry(MvvLva(m->p, move) + (1000 * (move == hashMove)), i, move);
+  }
+  m->next   = m->list;
+  m->last   = entry;
+  m->sorted = SortAbove(m->list, m->last, 0);
 }
 
 // ScoreQuiet() sorts quiet moves by history heuristic. For three classes
@@ -165,47 +273,82 @@ void sSelector::ScoreCaptures(int hashMove)
 // that refuted null move in the same node, (2) moves from refutation table
 // and (3) moves from continuation table (with a smaller bonus).
 
-void sSelector::ScoreQuiet(int refutationSq)
+void sSelector::ScoreQuiet(int *last, int refutationSq)
 {
-  int *movep, *valuep;
+  U64 *entry = m->list;
   int sortVal;
 
-  valuep = m->value;
-  for (movep = m->move; movep < m->last; movep++) {
+  for (int i = 0; m->move + i < last; i++) {
+    int move = m->move[i];
+    if (move == m->transMove 
+    ||  move == m->killer1 
+    ||  move == m->killer2)
+      continue;
     
 	// assign base sort value
-	sortVal =  History.GetMoveHistoryValue(m->p->pc[Fsq(*movep)], Tsq(*movep) );
+	sortVal =  History.GetMoveHistoryValue(m->p->pc[Fsq(move)], Tsq(move) );
 
     // null move refutations and ordinary refutation moves are sorted much higher	
-	if ( Fsq(*movep) == refutationSq 
-	||       *movep == m->refutation
+	if ( Fsq(move) == refutationSq 
+	||       move == m->refutation
 	 ) { 
-		 if ( Swap(m->p, Fsq(*movep), Tsq(*movep) ) >= -100 ) {
+		 if ( SeeGe(m->p, move, -100) ) {
 		     sortVal += 10000;
 	   }
     }
 
-    *valuep++ = sortVal;
+    *entry++ = Entry(sortVal, i, move);
   }
+  m->next   = m->list;
+  m->last   = entry;
+  m->sorted = SortAbove(m->list, m->last, Entry(QUIET_SORT_LIMIT + 1, MAX_MOVES - 1, 0));
 }
 
-int sSelector::PickBestMove(void)
+void sSelector::ScoreEvasions(int *last, int refutationSq)
 {
-  int *movep, *valuep, aux;
-
-  valuep = m->value + (m->last - m->move) - 1;
-  for (movep = m->last - 1; movep > m->next; movep--) {
-    if (*valuep > *(valuep - 1)) {
-      aux = *valuep;
-      *valuep = *(valuep - 1);
-      *(valuep - 1) = aux;
-      aux = *movep;
-      *movep = *(movep - 1);
-      *(movep - 1) = aux;
+  U64 *entry = m->list;
+  int sortVal;
+
+  for (int i = 0; m->move + i < last; i++) {
+    int move = m->move[i];
+    if (move == m->transMove) continue;
+
+    if (History.MoveChangesMaterialBalance(m->p, move)) {
+      if (CaptureIsBad(m->p, move)) sortVal = EVADE_BAD_CAPT  + MvvLva(m->p, move);
+      else                          sortVal = EVADE_GOOD_CAPT + MvvLva(m->p, move);
+    } 
+    else if (move == m->killer1)    sortVal = EVADE_KILLER + 1;
+    else if (move == m->killer2)    sortVal = EVADE_KILLER;
+    else {
+      sortVal = History.GetMoveHistoryValue(m->p->pc[Fsq(move)], Tsq(move));
+      if ( Fsq(move) == refutationSq 
+      ||       move == m->refutation ) {
+        if ( SeeGe(m->p, move, -100) ) 
+          sortVal += 10000;
+      }
     }
-    valuep--;
+    *entry++ = Entry(sortVal, i, move);
   }
-  return *m->next++;
+  m->next   = m->list;
+  m->last   = entry;
+  m->sorted = SortAbove(m->list, m->last, 0);
+}
+
+// Returns the best of the remaining moves. Within the sorted part it is
+// simply the next one; beyond it we look for the largest entry and swap
+// it into place.
+
+int sSelector::PickBestMove(void)
+{
+  if (m->next >= m->sorted) {
+    U64 *best = m->next;
+    for (U64 *e = m->next + 1; e < m->last; e++)
+      if (*e > *best) best = e;
+    U64 aux = *best;
+    *best = *m->next;
+    *m->next = aux;
+  }
+  return EntryMove(*m->next++);
 }
 
 int sSelector::CaptureIsBad(sPosition *p, int move)
@@ -213,7 +356,7 @@ int sSelector::CaptureIsBad(sPosition *p, int move)
   int fsq = Fsq(move);
   int tsq = Tsq(move);
 
-  // Marginal saving on value comparisons and Swap() calls. Here we accept
+  // Marginal saving on value comparisons and SeeGe() calls. Here we accept
   // "pawn takes any" and "minor takes minor", including BxN (added 2012-03-06)
   if ( TpOnSq(p, fsq) == P ) return 0;
   if ( TpOnSq(p, fsq) == N && TpOnSq(p, tsq) != P) return 0;
@@ -230,7 +373,7 @@ int sSelector::CaptureIsBad(sPosition *p, int move)
   if (bbPc(p, Opp(p->side), P) & bbPawnAttacks[p->side][tsq] ) return 1;
 
   // No shortcut worked - we must do expensive static exchange evaluation
-  return Swap(p, fsq, tsq) < -Data.goodCaptMargin;
+  return !SeeGe(p, move, -Data.goodCaptMargin);
 }
 
 // MvvLva() (stands for most valuable victim - least valuable attacker)
@@ -257,7 +400,19 @@ void sFlatMoveList::AddMove(int move)
 void sFlatMoveList::ClearUsed(int bestMove)
 {
      for (int i = 0; i < nOfMoves; i++)
-		used[i] = 0;
+		used[i] = excluded[i];
+}
+
+void sFlatMoveList::ClearExcluded(void)
+{
+     for (int i = 0; i < nOfMoves; i++)
+		excluded[i] = 0;
+}
+
+void sFlatMoveList::Exclude(int move)
+{
+	 for (int i = 0; i < nOfMoves; i++)
+		 if (moves[i] == move) excluded[i] = 1;
 }
 
 void sFlatMoveList::ScoreLastMove( int move, int val)
@@ -304,10 +459,6 @@ void sFlatMoveList::Init(sPosition * p)
 	while ( move = Selector.NextMove(0, &unusedFlag) ) {
 
       Manipulator.DoMove(p, move, undoData);
-      if (IllegalPosition(p)) { 
-		  Manipulator.UndoMove(p, move, undoData); 
-		  continue; 
-	  }
  
 	  value[nOfMoves] = -Searcher.Quiesce(p, 0, 0, -INF, INF, 1, pv);
 	  if (value[nOfMoves] > bestVal) {
@@ -318,4 +469,6 @@ void sFlatMoveList::Init(sPosition * p)
 	  AddMove(move);
 	  Manipulator.UndoMove(p, move, undoData);
 	}
+
+	ClearExcluded();
 }
@@ -35,8 +35,7 @@ void SetPosition(sPosition *p, char *epd)
   for (i = 0; i < 2; i++) {
     p->bbCl[i]      = 0ULL;
     p->pieceMat [i] = 0;
-    p->pstMg[i]     = 0;
-	p->pstEg[i]     = 0;
+    p->pst[i]       = 0;
 
 	for (j = 0; j < 6; j++) 
 		p->pcCount[i][j] = 0; // clear piece counts
@@ -66,8 +65,7 @@ void SetPosition(sPosition *p, char *epd)
         // update material, game phase and pst values
 		p->pieceMat[Cl(pc)]  += Data.matValue[Tp(pc)];
 		p->phase             += Data.phaseValue[Tp(pc)];
-        p->pstMg[Cl(pc)]     += Data.pstMg[Cl(pc)][Tp(pc)][i + j];
-		p->pstEg[Cl(pc)]     += Data.pstEg[Cl(pc)][Tp(pc)][i + j];
+        p->pst[Cl(pc)]       += Data.pst[Cl(pc)][Tp(pc)][i + j];
 		p->pcCount[Cl(pc)] [Tp(pc)]++;
         j++;
       }
@@ -110,4 +108,8 @@ void SetPosition(sPosition *p, char *epd)
   }
   p->hashKey = TransTable.InitHashKey(p);
   p->pawnKey = TransTable.InitPawnKey(p);
+  p->matKey  = TransTable.InitMaterialKey(p);
+#ifdef USE_ATTACK_MAPS
+  InitAttackMaps(p);
+#endif
 }
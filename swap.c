@@ -29,6 +29,12 @@ int Swap(sPosition *p, int from, int to)
 
   int side        = Opp(p->side); 
   int type        = TpOnSq(p, from);
+
+#ifdef USE_ATTACK_MAPS
+  // no recapture, not even through the moving piece
+  if (!(p->bbAttacks[side] & (SqBb(from) | SqBb(to)))) return swapVal[TpOnSq(p, to)];
+#endif
+
   U64 bbAttackers = AttacksTo(p, to);
   U64 bbOcupied   = OccBb(p) ^ SqBb(from);   // clear the moving piece
   score[0]        = swapVal[TpOnSq(p, to)];  // set initial gain
@@ -77,3 +83,80 @@ int Swap(sPosition *p, int from, int to)
 
   return score[0];
 }
+
+// SeeGe() tells whether Swap() for a move would return at least the
+// threshold. It follows the same rules, but keeps only the balance of
+// the exchange relative to the threshold and stops as soon as the side
+// to capture can no longer change the answer.
+
+int SeeGe(sPosition *p, int move, int threshold)
+{
+  U64 bbPieceType;
+
+  int from = Fsq(move);
+  int to   = Tsq(move);
+  int type = TpOnSq(p, from);
+
+  // even if nothing recaptures, the gain is too small
+  int balance = swapVal[TpOnSq(p, to)] - threshold;
+  if (balance < 0) return 0;
+
+  int side        = Opp(p->side);
+
+#ifdef USE_ATTACK_MAPS
+  // no recapture, not even through the moving piece
+  if (!(p->bbAttacks[side] & (SqBb(from) | SqBb(to)))) return 1;
+#endif
+
+  U64 bbAttackers = AttacksTo(p, to);
+  U64 bbOcupied   = OccBb(p) ^ SqBb(from);   // clear the moving piece
+
+  // update attacks through removed piece
+  if ( type == P || type == B || type == Q)
+      bbAttackers |= (BAttacks(bbOcupied, to) & (p->bbTp[B] | p->bbTp[Q]));
+  if ( type == R || type == Q )
+      bbAttackers |= (RAttacks(bbOcupied, to) & (p->bbTp[R] | p->bbTp[Q]));
+  bbAttackers &= bbOcupied;
+
+  // king may capture only an undefended piece
+  if (type == K) return !(bbAttackers & p->bbCl[side]);
+
+  // even if we lose the moving piece, the gain is big enough
+  balance = swapVal[type] - balance;
+  if (balance <= 0) return 1;
+
+  // "result" is the answer if the side that has just captured keeps
+  // the square; "balance" is what the next capturer has to win back
+  int result = 1;
+
+  while (bbAttackers & p->bbCl[side]) {
+    result ^= 1;
+
+    // find the lowest attacker
+    for (type = P; type <= K; type++)
+      if ((bbPieceType = bbPc(p, side, type) & bbAttackers))
+        break;
+
+    // king captures only if the opponent has no attackers left
+    if (type == K) 
+      return (bbAttackers & p->bbCl[Opp(side)]) ? result ^ 1 : result;
+
+    // losing this attacker in turn would not change the answer
+    balance = swapVal[type] - balance;
+    if (balance < result) break;
+
+    // remove attacker we have just found
+    bbOcupied ^= bbPieceType & -bbPieceType; 
+
+    // update attacks through removed piece
+    if ( type == P || type == B || type == Q)
+       bbAttackers |= (BAttacks(bbOcupied, to) & (p->bbTp[B] | p->bbTp[Q]));
+    if ( type == R || type == Q )
+       bbAttackers |= (RAttacks(bbOcupied, to) & (p->bbTp[R] | p->bbTp[Q]));
+    bbAttackers &= bbOcupied;
+
+    side ^= 1;
+  }
+
+  return result;
+}
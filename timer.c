@@ -25,8 +25,9 @@
 #if defined(_WIN32) || defined(_WIN64)
 #  include <windows.h>
 #else
+#  include <pthread.h>
 #  include <unistd.h>
-#  include <sys/time.h>
+#  include <time.h>
 #endif
 
 // we need macros here, because they can be used 
@@ -34,6 +35,16 @@
 #define EASY_TIME(time) ((time*2)/3)
 #define HARD_TIME(time) ((time*3)/2)
 
+#if defined(_WIN32) || defined(_WIN64)
+static HANDLE watchdogHandle;
+static DWORD WINAPI WatchdogEntry(LPVOID) { Timer.WatchdogLoop(); return 0; }
+#  define WatchdogSleep() Sleep(1)
+#else
+static pthread_t watchdogHandle;
+static void *WatchdogEntry(void *) { Timer.WatchdogLoop(); return NULL; }
+#  define WatchdogSleep() usleep(1000)
+#endif
+
 void sTimer::Clear(void) 
 {
   iterationTime = MAX_INT;
@@ -136,10 +147,10 @@ int sTimer::GetMS(void)
 #if defined(_WIN32) || defined(_WIN64)
   return GetTickCount();
 #else
-  struct timeval tv;
+  struct timespec ts;
 
-  gettimeofday(&tv, NULL);
-  return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+  clock_gettime(CLOCK_MONOTONIC, &ts); // unaffected by changes of system time
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 #endif
 }
 
@@ -191,3 +202,40 @@ void sTimer::WasteTime(int miliseconds)
 #endif
 // TODO: Linux version
 }
+
+// The watchdog runs on its own thread during a timed search and raises
+// the stop flag as soon as the time is up, so the moment search notices
+// it no longer depends on how fast nodes are searched.
+
+void sTimer::StartWatchdog(void)
+{
+  if (IsInfiniteMode()) return;
+
+  isWatching = 1;
+#if defined(_WIN32) || defined(_WIN64)
+  watchdogHandle = CreateThread(NULL, 0, WatchdogEntry, NULL, 0, NULL);
+#else
+  pthread_create(&watchdogHandle, NULL, WatchdogEntry, NULL);
+#endif
+}
+
+void sTimer::StopWatchdog(void)
+{
+  if (!isWatching) return;
+
+  isWatching = 0;
+#if defined(_WIN32) || defined(_WIN64)
+  WaitForSingleObject(watchdogHandle, INFINITE);
+  CloseHandle(watchdogHandle);
+#else
+  pthread_join(watchdogHandle, NULL);
+#endif
+}
+
+void sTimer::WatchdogLoop(void)
+{
+  while (isWatching) {
+    if (!pondering && TimeHasElapsed()) stopSearch = 1;
+    WatchdogSleep();
+  }
+}
@@ -45,6 +45,7 @@ private:
 	int moveTime;           // basic time allocated for a move
 	int maxMoveTime;        // time allocated for a move in more difficult circumstances
 	int minMoveTime;        // time allocated for an easy move
+	volatile int isWatching; // watchdog thread is running
 public:
 	void Clear(void);
 	void SetStartTime();
@@ -63,6 +64,9 @@ public:
 	void SetData(int slot, int val);
 	void SetSideData(int side);
 	void WasteTime(int miliseconds);
+	void StartWatchdog(void);
+	void StopWatchdog(void);
+	void WatchdogLoop(void);
 };
 
 extern sTimer Timer;
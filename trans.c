@@ -17,7 +17,18 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#endif
 #include "data.h"
 #include "rodent.h"
 #include "bitboard/bitboard.h"
@@ -55,76 +66,250 @@ U64 sTransTable::InitPawnKey(sPosition *p)
   return pawnKey;
 }
 
+// Material key has a random number for every piece present, chosen by its
+// kind and by how many such pieces are there before it (zobPiece[pc][n]).
+// Counting kings as well keeps the key non-zero, so that an empty slot of
+// the material table never matches.
+
+U64 sTransTable::InitMaterialKey(sPosition *p)
+{
+  U64 matKey = 0;
+
+  for (int cl = WHITE; cl <= BLACK; cl++) {
+    matKey ^= zobPiece[Pc(cl, K)][0];
+    for (int tp = P; tp < K; tp++)
+      for (int n = 0; n < p->pcCount[cl][tp]; n++)
+        matKey ^= zobPiece[Pc(cl, tp)][n];
+  }
+
+  return matKey;
+}
+
+
+// The table is obtained directly from the operating system, which gives
+// page-aligned memory, so every 64-byte bucket fits in one cache line.
+// Huge pages are requested first, as on big tables they remove most of
+// the TLB misses; if the system refuses, we use normal pages.
+
+static void *AllocPages(size_t *size)
+{
+  void *mem;
+#if defined(_WIN32) || defined(_WIN64)
+  SIZE_T largePage = GetLargePageMinimum();
+  if (largePage) {
+    SIZE_T largeSize = (*size + largePage - 1) / largePage * largePage;
+    mem = VirtualAlloc(NULL, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (mem) {
+      *size = largeSize;
+      return mem;
+    }
+  }
+  return VirtualAlloc(NULL, *size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  const size_t hugePage = 2 << 20;
+#  ifdef MAP_HUGETLB
+  size_t hugeSize = (*size + hugePage - 1) / hugePage * hugePage;
+  mem = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mem != MAP_FAILED) {
+    *size = hugeSize;
+    return mem;
+  }
+#  endif
+  mem = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) return NULL;
+#  ifdef MADV_HUGEPAGE
+  if (*size >= hugePage) madvise(mem, *size, MADV_HUGEPAGE); // transparent huge pages
+#  endif
+  return mem;
+#endif
+}
+
+static void FreePages(void *mem, size_t size, int isMapped)
+{
+  if (!mem) return;
+#if defined(_WIN32) || defined(_WIN64)
+  if (isMapped) UnmapViewOfFile(mem);
+  else          VirtualFree(mem, 0, MEM_RELEASE);
+#else
+  (void)isMapped; // munmap() releases file views and anonymous memory alike
+  munmap(mem, size);
+#endif
+}
+
+// Hash size may be any number of megabytes; buckets are addressed by
+// multiply-shift (see TtBucketIndex()), not by masking the key.
 
 void sTransTable::Alloc(int mbsize)
 {
-  for (tt_size = 2; tt_size <= mbsize; tt_size *= 2)
-    ;
-  tt_size = ((tt_size / 2) << 20) / sizeof(ENTRY);
-  tt_mask = tt_size - 4;
-  free(tt);
-  tt = (ENTRY *) malloc(tt_size * sizeof(ENTRY));
+  U64 bytes = (U64)Max(mbsize, 1) << 20;
+
+  FreePages(tt, tt_bytes, tt_mapped);
+  tt_mapped = 0;
+  for (;;) {
+    tt_bytes = (size_t)bytes;
+    tt = (ENTRY *) AllocPages(&tt_bytes);
+    if (tt || bytes <= (1 << 20)) break;
+    bytes /= 2; // not enough memory, retry with a smaller table
+  }
+  if (!tt) {
+    printf("info string could not allocate hash table\n");
+    exit(1);
+  }
+  if (bytes < ((U64)Max(mbsize, 1) << 20))
+    printf("info string hash table reduced to " llu_format " MB\n", bytes >> 20);
+
+  tt_buckets = bytes / (4 * sizeof(ENTRY));
+  tt_size = tt_buckets * 4;
   Clear();
 }
 
+// Clearing a table of many gigabytes takes seconds on a single core,
+// so large tables are zeroed by several threads, each taking a slice.
+
+#define CLEAR_SLICE    (64 << 20) // don't start a thread for less than 64 MB
+#define MAX_CLEAR_JOBS 64
+
+struct sClearJob {
+  char *start;
+  size_t len;
+};
+
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI ClearJob(LPVOID arg) { sClearJob *job = (sClearJob *)arg; memset(job->start, 0, job->len); return 0; }
+#else
+static void *ClearJob(void *arg) { sClearJob *job = (sClearJob *)arg; memset(job->start, 0, job->len); return NULL; }
+#endif
+
+static int CountCpus(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+#else
+  return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
 void sTransTable::Clear(void)
 {
-  ENTRY *entry;
+  sClearJob job[MAX_CLEAR_JOBS];
+  size_t bytes = (size_t)(tt_size * sizeof(ENTRY));
+  size_t slice;
+  int i, nOfJobs;
 
   tt_date = 0;
-  for (entry = tt; entry < tt + tt_size; entry++) {
-    entry->key = 0;
-    entry->date = 0;
-    entry->move = 0;
-    entry->score = 0;
-    entry->flags = 0;
-    entry->depth = 0;
+
+  nOfJobs = (int)Min((U64)CountCpus(), (U64)(bytes / CLEAR_SLICE));
+  nOfJobs = Max(1, Min(nOfJobs, MAX_CLEAR_JOBS));
+  if (nOfJobs == 1) {
+    memset(tt, 0, bytes);
+    return;
   }
+
+  // slices are multiples of a bucket; the last one takes the remainder
+  slice = bytes / nOfJobs / 64 * 64;
+  for (i = 0; i < nOfJobs; i++) {
+    job[i].start = (char *)tt + i * slice;
+    job[i].len   = (i == nOfJobs - 1) ? bytes - i * slice : slice;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  HANDLE handle[MAX_CLEAR_JOBS];
+  for (i = 1; i < nOfJobs; i++)
+    handle[i] = CreateThread(NULL, 0, ClearJob, &job[i], 0, NULL);
+  ClearJob(&job[0]);
+  for (i = 1; i < nOfJobs; i++) {
+    WaitForSingleObject(handle[i], INFINITE);
+    CloseHandle(handle[i]);
+  }
+#else
+  pthread_t handle[MAX_CLEAR_JOBS];
+  for (i = 1; i < nOfJobs; i++)
+    pthread_create(&handle[i], NULL, ClearJob, &job[i]);
+  ClearJob(&job[0]);
+  for (i = 1; i < nOfJobs; i++)
+    pthread_join(handle[i], NULL);
+#endif
+}
+
+// FindEntry() returns the entry matching the key (or NULL) together with
+// a copy of its data. The copy is validated against the key, so that an
+// entry being overwritten by another thread is treated as a miss. With
+// SSE2 the four keys of a bucket are checked with two vector compares.
+
+ENTRY *sTransTable::FindEntry(U64 key, U64 *data)
+{
+  ENTRY *bucket = tt + TtBucketIndex(key, tt_buckets) * 4;
+  int i;
+
+#ifdef USE_TT_SSE2
+  __m128i target = _mm_loadl_epi64((const __m128i *)&key);
+  target = _mm_unpacklo_epi64(target, target);
+  __m128i e0 = _mm_load_si128((const __m128i *)(bucket + 0));
+  __m128i e1 = _mm_load_si128((const __m128i *)(bucket + 1));
+  __m128i e2 = _mm_load_si128((const __m128i *)(bucket + 2));
+  __m128i e3 = _mm_load_si128((const __m128i *)(bucket + 3));
+
+  // key ^ data of entries 0,1 and 2,3
+  __m128i k01 = _mm_xor_si128(_mm_unpacklo_epi64(e0, e1), _mm_unpackhi_epi64(e0, e1));
+  __m128i k23 = _mm_xor_si128(_mm_unpacklo_epi64(e2, e3), _mm_unpackhi_epi64(e2, e3));
+  int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(k01, target))
+           | _mm_movemask_epi8(_mm_cmpeq_epi32(k23, target)) << 16;
+
+  // an entry matches if all 8 bytes of its key compare equal
+  for (i = 0; i < 4; i++, mask >>= 8) {
+    if ((mask & 0xff) == 0xff) {
+      *data = bucket[i].data;
+      if ((bucket[i].key ^ *data) == key) return bucket + i;
+    }
+  }
+#else
+  for (i = 0; i < 4; i++) {
+    *data = bucket[i].data;
+    if ((bucket[i].key ^ *data) == key) return bucket + i;
+  }
+#endif
+  return NULL;
 }
 
 int sTransTable::Retrieve(U64 key, int *move, int *score, int alpha, int beta, int depth, int ply)
 {
   ENTRY *entry;
-  int i;
+  U64 data;
+  int flags;
   // TODO: node type as input and return only exact scores in pv nodes
 
-  entry = tt + (key & tt_mask);
-  for (i = 0; i < 4; i++) {
-    if (entry->key == key) {
-      *move = entry->move;
-      if (entry->depth >= depth) {
-        *score = entry->score;
-        if (*score < -MAX_EVAL)
-          *score += ply;
-        else if (*score > MAX_EVAL)
-          *score -= ply;
-        if ((entry->flags & UPPER && *score <= alpha) ||
-            (entry->flags & LOWER && *score >= beta) )
-		    {
-            entry->date = tt_date; // refreshing entry
-            return 1;
-            }
+  entry = FindEntry(key, &data);
+  if (entry) {
+    *move = TtMove(data);
+    if (TtDepth(data) >= depth) {
+      *score = TtScore(data);
+      flags = TtFlags(data);
+      if (*score < -MAX_EVAL)
+        *score += ply;
+      else if (*score > MAX_EVAL)
+        *score -= ply;
+      if ((flags & UPPER && *score <= alpha) ||
+          (flags & LOWER && *score >= beta) )
+      {
+        // refreshing entry
+        data = TtPack(TtMove(data), TtScore(data), CurrentEval(data), tt_date, flags, TtDepth(data));
+        entry->key = key ^ data;
+        entry->data = data;
+        return 1;
       }
-      break;
     }
-    entry++;
   }
   return 0;
 }
 
  void sTransTable::RetrieveMove(U64 key, int *move )
  {
-  ENTRY *entry;
-  int i;
+  U64 data;
   *move = 0;
-  entry = tt + (key & tt_mask);
-  for (i = 0; i < 4; i++) {
-    if (entry->key == key) {
-    *move = entry->move; // found
-     break;
-              }
-    entry++;
-  }
+  if (FindEntry(key, &data))
+    *move = TtMove(data); // found
  }
 
 // This is an idea from Stockfish: eval score used in search for pruning
@@ -133,58 +318,468 @@ int sTransTable::Retrieve(U64 key, int *move, int *score, int alpha, int beta, i
 
 int sTransTable::RefineScore(U64 key, int score)
 {
-  ENTRY *entry;
-  int i;
+  U64 data;
   int val;
 
-  entry = tt + (key & tt_mask);
-  for (i = 0; i < 4; i++) {
-    if (entry->key == key) 
+  if (FindEntry(key, &data))
 	{
-      val = entry->score;		
-      if  (entry->flags & UPPER ) return Max(score, val);
-      if  (entry->flags & LOWER ) return Min(score, val);                
-      break;
+      val = TtScore(data);
+      if  (TtFlags(data) & UPPER ) return Max(score, val);
+      if  (TtFlags(data) & LOWER ) return Min(score, val);                
     }
-    entry++;
-  }
   return score;
 }
 
-void sTransTable::Store(U64 key, int move, int score, int flags, int depth, int ply)
+// chooses the entry to be overwritten by a new position: the oldest one,
+// and of those equally old, the one searched to the smallest depth
+
+ENTRY *sTransTable::ReplaceSlot(ENTRY *bucket)
 {
-  ENTRY *entry, *replace;
-  int i, oldest, age;
+  ENTRY *replace = bucket;
+  int i, age, oldest = -1;
+
+  for (i = 0; i < 4; i++) {
+    U64 data = bucket[i].data;
+    age = ((tt_date - TtDate(data)) & TT_DATE_MASK) * 256 + 255 - (TtDepth(data) / ONE_PLY);
+    if (age > oldest) {
+      oldest = age;
+      replace = bucket + i;
+    }
+  }
+  return replace;
+}
+
+// classifies the entry about to be overwritten by a different position
+
+int sTransTable::ReplaceReason(U64 oldKey, U64 oldData, int depth)
+{
+  if (!oldKey && !oldData)        return REPLACE_EMPTY;
+  if (TtDate(oldData) != tt_date) return REPLACE_OLD;
+  if (TtDepth(oldData) > depth)   return REPLACE_DEEPER;
+  return REPLACE_SHALLOWER;
+}
+
+int sTransTable::Store(U64 key, int move, int score, int flags, int depth, int ply, int eval)
+{
+  ENTRY *replace;
+  U64 data;
+  int reason = REPLACE_SAME;
 
   if (score < -MAX_EVAL)
     score -= ply;
   else if (score > MAX_EVAL)
     score += ply;
-  replace = NULL;
-  oldest = -1;
-  entry = tt + (key & tt_mask);
-  for (i = 0; i < 4; i++) {
-    if (entry->key == key) {
-      if (!move) move = entry->move; // preserve hash move
-      replace = entry;
-      break;
-    }
-    age = ((tt_date - entry->date) & 255) * 256 + 255 - (entry->depth / ONE_PLY);
-    if (age > oldest) {
-      oldest = age;
-      replace = entry;
+  depth = Min(depth, TT_MAX_DEPTH);
+  replace = FindEntry(key, &data);
+  if (replace) {
+    if (!move) move = TtMove(data); // preserve hash move
+    if (eval == INVALID) eval = CurrentEval(data); // and static eval
+  } else {
+    replace = ReplaceSlot(tt + TtBucketIndex(key, tt_buckets) * 4);
+    reason = ReplaceReason(replace->key, replace->data, depth);
+  }
+
+  data = TtPack(move, score, eval, tt_date, flags, depth);
+  replace->key = key ^ data;
+  replace->data = data;
+  return reason;
+}
+
+// Search() probes the bucket once and keeps the result in a PROBE handle,
+// which then serves the cutoff test, the hash move, refining eval and the
+// final store, instead of each of them scanning the bucket anew.
+
+void sTransTable::Probe(U64 key, PROBE *h)
+{
+  h->key = key;
+  h->slot = FindEntry(key, &h->data);
+  h->found = (h->slot != NULL);
+  if (!h->found) {
+    h->slot = ReplaceSlot(tt + TtBucketIndex(key, tt_buckets) * 4);
+    h->data = 0;
+  }
+  h->slotKey = h->slot->key;
+}
+
+int sTransTable::Retrieve(PROBE *h, int *score, int alpha, int beta, int depth, int ply)
+{
+  int flags;
+
+  if (!h->found || TtDepth(h->data) < depth) return 0;
+
+  *score = TtScore(h->data);
+  flags = TtFlags(h->data);
+  if (*score < -MAX_EVAL)
+    *score += ply;
+  else if (*score > MAX_EVAL)
+    *score -= ply;
+  if ((flags & UPPER && *score <= alpha) ||
+      (flags & LOWER && *score >= beta) )
+  {
+    // refreshing entry, unless another thread has overwritten it meanwhile
+    if (h->slot->key == h->slotKey) {
+      h->data = TtPack(TtMove(h->data), TtScore(h->data), CurrentEval(h->data), tt_date, flags, TtDepth(h->data));
+      h->slotKey = h->key ^ h->data;
+      h->slot->key = h->slotKey;
+      h->slot->data = h->data;
     }
-    entry++;
+    return 1;
   }
-  replace->key = key; 
-  replace->date = tt_date; 
-  replace->move = move;
-  replace->score = score; 
-  replace->flags = flags; 
-  replace->depth = depth;
+  return 0;
+}
+
+int sTransTable::RefineScore(PROBE *h, int score)
+{
+  int val;
+
+  if (h->found) {
+    val = TtScore(h->data);
+    if  (TtFlags(h->data) & UPPER ) return Max(score, val);
+    if  (TtFlags(h->data) & LOWER ) return Min(score, val);
+  }
+  return score;
+}
+
+// The slot chosen during the probe is used if nothing has been written
+// there since (searching the children may have stored other positions
+// in the same bucket); otherwise we fall back to the normal Store().
+
+int sTransTable::Store(PROBE *h, int move, int score, int flags, int depth, int ply, int eval)
+{
+  U64 data;
+  int reason = REPLACE_SAME;
+
+  if (h->slot->key != h->slotKey)
+    return Store(h->key, move, score, flags, depth, ply, eval);
+
+  if (score < -MAX_EVAL)
+    score -= ply;
+  else if (score > MAX_EVAL)
+    score += ply;
+  depth = Min(depth, TT_MAX_DEPTH);
+  if (h->found) {
+    if (!move) move = TtMove(h->data); // preserve hash move
+    if (eval == INVALID) eval = CurrentEval(h->data); // and static eval
+  } else
+    reason = ReplaceReason(h->slotKey, h->slot->data, depth);
+
+  data = TtPack(move, score, eval, tt_date, flags, depth);
+  h->slot->key = h->key ^ data;
+  h->slot->data = data;
+  return reason;
 }
 
 void sTransTable::ChangeDate() 
 {
-  tt_date = (tt_date + 1) & 255;
+  tt_date = (tt_date + 1) & TT_DATE_MASK;
+}
+
+// The date has only 6 bits, so once it wraps around, evals saved 64
+// searches ago would pass for current ones. ClearEvals() is called at
+// that point; it keeps the rest of each entry. No other thread may be
+// using the table.
+
+void sTransTable::ClearEvals(void)
+{
+  for (U64 i = 0; i < tt_size; i++) {
+    U64 data = tt[i].data;
+    if (!(tt[i].key || data) || TtEval(data) == INVALID) continue; // empty or nothing to clear
+    U64 key = tt[i].key ^ data;
+    data = TtPack(TtMove(data), TtScore(data), INVALID, TtDate(data), TtFlags(data), TtDepth(data));
+    tt[i].key = key ^ data;
+    tt[i].data = data;
+  }
+}
+
+// Permill of entries written in the current search, estimated from the
+// first 1000 entries. Multiply-shift indexing spreads keys uniformly over
+// the table, so the beginning of the table is as good a sample as any.
+
+int sTransTable::HashFull(void)
+{
+  int cnt = 0;
+  int sample = (int)Min(tt_size, (U64)1000);
+
+  for (int i = 0; i < sample; i++) {
+    U64 data = tt[i].data;
+    if ((tt[i].key || data) && TtDate(data) == tt_date) cnt++;
+  }
+  return cnt * 1000 / Max(sample, 1);
+}
+
+// Prints occupancy of the table by age and depth of entries,
+// estimated from entries in evenly spaced buckets.
+
+#define OCCUPANCY_SAMPLE 100000
+
+void sTransTable::DisplayOccupancy(void)
+{
+  static const char *depthName[5] = { "qs", "1-4", "5-8", "9-16", "17+" };
+  U64 age[4] = {0}, depthCnt[5] = {0};
+  U64 empty = 0, sampled = 0;
+  U64 step = Max(tt_buckets / (OCCUPANCY_SAMPLE / 4), (U64)1);
+
+  for (U64 b = 0; b < tt_buckets; b += step) {
+    for (int i = 0; i < 4; i++) {
+      ENTRY *entry = tt + b * 4 + i;
+      U64 data = entry->data;
+      sampled++;
+      if (!entry->key && !data) {
+        empty++;
+        continue;
+      }
+      age[Min((tt_date - TtDate(data)) & TT_DATE_MASK, 3)]++;
+      int plies = TtDepth(data) / ONE_PLY;
+      if      (plies == 0)  depthCnt[0]++;
+      else if (plies <= 4)  depthCnt[1]++;
+      else if (plies <= 8)  depthCnt[2]++;
+      else if (plies <= 16) depthCnt[3]++;
+      else                  depthCnt[4]++;
+    }
+  }
+
+  sampled = Max(sampled, (U64)1);
+  printf("Hash: " llu_format " MB, " llu_format " entries, %d permill used in current search\n",
+          (U64)(tt_size * sizeof(ENTRY)) >> 20, tt_size, HashFull() );
+  printf("Sampled " llu_format " entries, empty: %.1f%%\n", sampled, 100.0 * empty / sampled);
+  printf("By age   : current %.1f%%, 1 search old %.1f%%, 2 old %.1f%%, 3+ old %.1f%%\n",
+          100.0 * age[0] / sampled, 100.0 * age[1] / sampled, 100.0 * age[2] / sampled, 100.0 * age[3] / sampled);
+  printf("By depth :");
+  for (int i = 0; i < 5; i++)
+    printf(" %s %.1f%%%s", depthName[i], 100.0 * depthCnt[i] / sampled, i < 4 ? "," : "\n");
+}
+
+// Hash file consists of a header, padded to TT_FILE_OFFSET bytes, followed
+// by a raw image of the table. The padding keeps the table aligned, so that
+// Load() can map the file into memory instead of reading and parsing it;
+// pages are then brought in by the system as the search touches them.
+// Writes to the mapped table are private and never reach the file.
+
+#define TT_FILE_MAGIC   "RodentTT"
+#define TT_FILE_VERSION 1
+#define TT_FILE_OFFSET  65536 // a multiple of page size and of Windows allocation granularity
+
+typedef struct {      // header of a saved hash file
+  char magic[8];
+  int version;
+  int date;
+  U64 zobristSeed;
+  U64 zobristCheck;   // all Zobrist keys xor-ed, in case the generator itself has changed
+  U64 bytes;          // size of the table
+} TT_HEADER;
+
+// ZobristCheck() sums up the whole key set, so that files keyed by hash keys
+// (saved hash files, lrn.dat) can tell whether they were written with it
+
+U64 sTransTable::ZobristCheck(void)
+{
+  U64 check = SIDE_RANDOM;
+
+  for (int i = 0; i < 12; i++)
+    for (int j = 0; j < 64; j++)
+      check ^= zobPiece[i][j] * (j + 1);
+  for (int i = 0; i < 16; i++) check ^= zobCastle[i];
+  for (int i = 0; i < 8; i++)  check ^= zobEp[i];
+  return check;
+}
+
+int sTransTable::Save(const char *fileName)
+{
+  FILE *hashFile;
+  TT_HEADER header;
+  static char padding[TT_FILE_OFFSET];
+  size_t bytes = (size_t)(tt_size * sizeof(ENTRY));
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TT_FILE_MAGIC, 8);
+  header.version = TT_FILE_VERSION;
+  header.date = tt_date;
+  header.zobristSeed = ZOBRIST_SEED;
+  header.zobristCheck = ZobristCheck();
+  header.bytes = bytes;
+
+  if ( (hashFile = fopen(fileName, "wb")) == NULL ) {
+    printf("info string cannot create hash file %s\n", fileName);
+    return 0;
+  }
+
+  int isWritten = fwrite(&header, sizeof(header), 1, hashFile) == 1
+               && fwrite(padding, TT_FILE_OFFSET - sizeof(header), 1, hashFile) == 1
+               && fwrite(tt, 1, bytes, hashFile) == bytes;
+  fclose(hashFile);
+
+  if (!isWritten) printf("info string error writing hash file %s\n", fileName);
+  else            printf("info string hash saved to %s\n", fileName);
+  return isWritten;
+}
+
+int sTransTable::Load(const char *fileName)
+{
+  FILE *hashFile;
+  TT_HEADER header;
+  size_t bytes = (size_t)(tt_size * sizeof(ENTRY));
+  void *mem;
+
+  if ( (hashFile = fopen(fileName, "rb")) == NULL ) {
+    printf("info string cannot open hash file %s\n", fileName);
+    return 0;
+  }
+  int isRead = fread(&header, sizeof(header), 1, hashFile) == 1;
+  fclose(hashFile);
+
+  // reject files written by a different engine version or for a different Hash size
+  if (!isRead
+  ||  memcmp(header.magic, TT_FILE_MAGIC, 8)
+  ||  header.version != TT_FILE_VERSION
+  ||  header.zobristSeed != ZOBRIST_SEED
+  ||  header.zobristCheck != ZobristCheck()) {
+    printf("info string %s is not a valid hash file\n", fileName);
+    return 0;
+  }
+  if (header.bytes != bytes) {
+    printf("info string hash file %s needs Hash " llu_format " MB\n", fileName, header.bytes >> 20);
+    return 0;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) return 0;
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping) return 0;
+  mem = MapViewOfFile(mapping, FILE_MAP_COPY, 0, TT_FILE_OFFSET, bytes);
+  CloseHandle(mapping);
+#else
+  int file = open(fileName, O_RDONLY);
+  if (file < 0) return 0;
+  mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, TT_FILE_OFFSET);
+  close(file);
+  if (mem == MAP_FAILED) mem = NULL;
+#  ifdef MADV_WILLNEED
+  else madvise(mem, bytes, MADV_WILLNEED); // start reading ahead
+#  endif
+#endif
+
+  if (!mem) {
+    printf("info string cannot map hash file %s\n", fileName);
+    return 0;
+  }
+
+  FreePages(tt, tt_bytes, tt_mapped);
+  tt = (ENTRY *) mem;
+  tt_bytes = bytes;
+  tt_mapped = 1;
+  tt_date = header.date;
+  printf("info string hash loaded from %s\n", fileName);
+  return 1;
+}
+
+void sQsTable::Alloc(int mbsize)
+{
+  FreePages(qt, qt_bytes, 0);
+  qt_bytes = (size_t)Max(mbsize, 1) << 20;
+  qt = (ENTRY *) AllocPages(&qt_bytes);
+  if (!qt) {
+    printf("info string could not allocate quiescence hash table\n");
+    exit(1);
+  }
+  qt_size = ((U64)Max(mbsize, 1) << 20) / sizeof(ENTRY);
+  Clear();
+}
+
+void sQsTable::Clear(void)
+{
+  memset(qt, 0, (size_t)(qt_size * sizeof(ENTRY)));
+}
+
+void sQsTable::Probe(U64 key, PROBE *h)
+{
+  h->key = key;
+  h->slot = qt + TtBucketIndex(key, qt_size);
+  h->data = h->slot->data;
+  h->found = ((h->slot->key ^ h->data) == key);
+  if (!h->found) h->data = 0;
+}
+
+int sQsTable::Retrieve(PROBE *h, int *score, int alpha, int beta, int ply)
+{
+  int flags;
+
+  if (!h->found) return 0;
+
+  *score = TtScore(h->data);
+  flags = TtFlags(h->data);
+  if (*score < -MAX_EVAL)
+    *score += ply;
+  else if (*score > MAX_EVAL)
+    *score -= ply;
+  return (flags & UPPER && *score <= alpha) 
+      || (flags & LOWER && *score >= beta);
+}
+
+void sQsTable::Store(PROBE *h, int move, int score, int flags, int ply, int eval)
+{
+  U64 data;
+
+  if (score < -MAX_EVAL)
+    score -= ply;
+  else if (score > MAX_EVAL)
+    score += ply;
+  if (h->found) {
+    if (!move) move = TtMove(h->data); // preserve hash move
+    if (eval == INVALID && TtDate(h->data) == TransTable.GetDate()) 
+      eval = TtEval(h->data);          // and static eval
+  }
+
+  data = TtPack(move, score, eval, TransTable.GetDate(), flags, 0);
+  h->slot->key = h->key ^ data;
+  h->slot->data = data;
+}
+
+void sEvalTable::Alloc(int mbsize)
+{
+  FreePages(et, et_bytes, 0);
+  et = NULL;
+  et_size = 0;
+  et_mb = Max(mbsize, 0);
+  if (mbsize <= 0) return;  // eval cache switched off
+
+  et_bytes = (size_t)mbsize << 20;
+  et = (ENTRY *) AllocPages(&et_bytes);
+  if (!et) {
+    printf("info string could not allocate eval cache\n");
+    exit(1);
+  }
+  et_size = ((U64)mbsize << 20) / sizeof(ENTRY);
+  Clear();
+}
+
+void sEvalTable::Clear(void)
+{
+  if (et) memset(et, 0, (size_t)(et_size * sizeof(ENTRY)));
+}
+
+int sEvalTable::Probe(U64 key, int *score, int *estimate, int *isExact)
+{
+  if (!et_size) return 0;
+
+  ENTRY *slot = et + TtBucketIndex(key, et_size);
+  U64 data = slot->data;
+  if ((slot->key ^ data) != key || EcDate(data) != TransTable.GetDate()) return 0;
+
+  *score = EcScore(data);
+  *estimate = EcEstimate(data);
+  *isExact = EcExact(data);
+  return 1;
+}
+
+void sEvalTable::Store(U64 key, int score, int estimate, int isExact)
+{
+  if (!et_size) return;
+  if (!isExact && estimate != (short)estimate) return; // lazy entry would be unusable
+
+  ENTRY *slot = et + TtBucketIndex(key, et_size);
+  U64 data = EcPack(score, estimate, isExact, TransTable.GetDate());
+  slot->key = key ^ data;
+  slot->data = data;
 }
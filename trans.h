@@ -19,31 +19,177 @@
 
 #pragma once
 
+// SSE2 is used for comparing keys of a whole bucket at once and for
+// prefetching; it is available on every x64 compiler
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#  define USE_TT_SSE2
+#  include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+// Entries can be read and written by several threads at once without any
+// locking. Instead of the raw hash key, an entry keeps the key xor-ed with
+// its data, so that an entry torn by two concurrent writers fails the key
+// comparison and is treated as a miss.
+
 typedef struct {      // transposition table entry
-  U64 key;
-  short date;
-  short move;
-  short score;
-  unsigned char flags;
-  unsigned char depth;
+  U64 key;            // hash key ^ data
+  U64 data;           // move, score, static eval, depth, flags and date packed together
 } ENTRY;
 
+// Static eval is stored only when it has been calculated in full (not
+// lazily), and it is trusted only in the search that stored it, as eval
+// parameters may change between searches (see Data.InitAsymmetric()).
+// When the date wraps around, saved evals are cleared (see ClearEvals()).
+
+#define TT_DATE_MASK    63
+#define TT_MAX_DEPTH    255 // depth field has 8 bits, deeper entries are stored with this depth
+
+#define TtPack(move, score, eval, date, flags, depth) \
+  ( (U64)(unsigned short)(move) | ((U64)(unsigned short)(score) << 16) \
+  | ((U64)(unsigned short)(eval) << 32) | ((U64)((depth) & 0xff) << 48) \
+  | ((U64)(flags) << 56) | ((U64)(date) << 58) )
+
+#define TtMove(data)    ((int)((data) & 0xffff))
+#define TtScore(data)   ((int)(short)(((data) >> 16) & 0xffff))
+#define TtEval(data)    ((int)(short)(((data) >> 32) & 0xffff))
+#define TtDepth(data)   ((int)(((data) >> 48) & 0xff))
+#define TtFlags(data)   ((int)(((data) >> 56) & 3))
+#define TtDate(data)    ((int)(((data) >> 58) & TT_DATE_MASK))
+
+// Maps a key onto a bucket index in [0, nOfBuckets) using the high half
+// of a 64x64 bit product, so that the number of buckets doesn't have to
+// be a power of two.
+
+static inline U64 TtBucketIndex(U64 key, U64 nOfBuckets)
+{
+#if defined(__SIZEOF_INT128__)
+  return (U64)(((unsigned __int128)key * nOfBuckets) >> 64);
+#elif defined(_M_X64) || defined(_M_AMD64)
+  return __umulh(key, nOfBuckets);
+#else
+  U64 kLo = key & 0xffffffff, kHi = key >> 32;
+  U64 nLo = nOfBuckets & 0xffffffff, nHi = nOfBuckets >> 32;
+  U64 mid = ((kLo * nLo) >> 32) + (kHi * nLo & 0xffffffff) + kLo * nHi;
+  return kHi * nHi + (kHi * nLo >> 32) + (mid >> 32);
+#endif
+}
+
+typedef struct {      // result of probing the table once per node
+  U64 key;
+  U64 data;           // copy of the matching entry's data, taken during the probe
+  U64 slotKey;        // key word of the slot as it was during the probe
+  ENTRY *slot;        // matching entry or, on a miss, the entry to be replaced
+  int found;
+} PROBE;
+
+// Store() tells what kind of entry has been overwritten, for statistics
+enum eTtReplace { REPLACE_SAME, REPLACE_EMPTY, REPLACE_OLD, REPLACE_SHALLOWER, REPLACE_DEEPER };
+
 struct sTransTable {  // transposition table with access functions
 private:
-  int tt_size;
-  int tt_mask;
+  U64 tt_size;        // number of entries
+  U64 tt_buckets;     // number of 4-entry buckets
+  size_t tt_bytes;    // size of memory block obtained from the system
+  int tt_mapped;      // is the table a mapped view of a saved hash file?
   int tt_date;
-  ENTRY *tt;
+  ENTRY *tt;          // page aligned, so that each 4-entry bucket fills one cache line
+  ENTRY *FindEntry(U64 key, U64 *data);
+  ENTRY *ReplaceSlot(ENTRY *bucket);
+  int ReplaceReason(U64 oldKey, U64 oldData, int depth);
+  int CurrentEval(U64 data) { return TtDate(data) == tt_date ? TtEval(data) : INVALID; }
 public:
   U64 InitHashKey(sPosition *p);
   U64 InitPawnKey(sPosition *p);
+  U64 InitMaterialKey(sPosition *p);
+  U64 ZobristCheck(void);
   void Alloc(int);
   void Clear(void);
   int Retrieve(U64 key, int *move, int *score, int alpha, int beta, int depth, int ply);
   void RetrieveMove(U64 key, int *move );
   int RefineScore(U64 key, int score);
-  void Store(U64 key, int move, int score, int flags, int depth, int ply);
+  int Store(U64 key, int move, int score, int flags, int depth, int ply, int eval);
+
+  // the same operations, working on the result of a single probe
+  void Probe(U64 key, PROBE *h);
+  int Retrieve(PROBE *h, int *score, int alpha, int beta, int depth, int ply);
+  int GetMove(PROBE *h) { return h->found ? TtMove(h->data) : 0; }
+  int GetEval(PROBE *h) { return h->found ? CurrentEval(h->data) : INVALID; }
+  int RefineScore(PROBE *h, int score);
+  int Store(PROBE *h, int move, int score, int flags, int depth, int ply, int eval);
   void ChangeDate();
+  void ClearEvals(void);
+  U64 BucketCount(void) { return tt_buckets; }
+  int GetDate(void) { return tt_date; }
+  int HashFull(void);
+  void DisplayOccupancy(void);
+  int Save(const char *fileName);
+  int Load(const char *fileName);
+
+  // called as soon as the key of a child node is known, so that its bucket
+  // is already in cache when the child probes the table
+  void Prefetch(U64 key) {
+#if defined(USE_TT_SSE2)
+    _mm_prefetch((const char *)(tt + TtBucketIndex(key, tt_buckets) * 4), _MM_HINT_T0);
+#elif defined(__GNUC__)
+    __builtin_prefetch(tt + TtBucketIndex(key, tt_buckets) * 4);
+#endif
+  }
 };
 
 extern sTransTable TransTable;
+
+// Quiescence search results go to a separate, small table, so that they
+// don't push deeper entries out of the main table. It is direct-mapped
+// and always replaces, as qsearch entries are cheap to recreate. Entries
+// are packed the same way as in the main table, with depth left unused.
+
+struct sQsTable {
+private:
+  ENTRY *qt;
+  U64 qt_size;        // number of entries
+  size_t qt_bytes;
+public:
+  void Alloc(int mbsize);
+  void Clear(void);
+  void Probe(U64 key, PROBE *h);
+  int Retrieve(PROBE *h, int *score, int alpha, int beta, int ply);
+  int GetMove(PROBE *h) { return h->found ? TtMove(h->data) : 0; }
+  int GetEval(PROBE *h) { return h->found && TtDate(h->data) == TransTable.GetDate() ? TtEval(h->data) : INVALID; }
+  void Store(PROBE *h, int move, int score, int flags, int ply, int eval);
+};
+
+extern sQsTable QsTable;
+
+// Eval cache. ReturnFull() stores every score it calculates, together with
+// the lazy estimate that decided whether evaluation was done in full. An
+// exact score is valid for any window, a lazy one only for windows that
+// would cause the same lazy cutoff. Like static eval in the tables above,
+// an entry is trusted only in the search that stored it.
+
+#define EcPack(score, estimate, isExact, date) \
+  ( (U64)(unsigned short)(score) | ((U64)(unsigned short)(estimate) << 16) \
+  | ((U64)(isExact) << 32) | ((U64)(date) << 33) )
+
+#define EcScore(data)    ((int)(short)((data) & 0xffff))
+#define EcEstimate(data) ((int)(short)(((data) >> 16) & 0xffff))
+#define EcExact(data)    ((int)(((data) >> 32) & 1))
+#define EcDate(data)     ((int)(((data) >> 33) & TT_DATE_MASK))
+
+struct sEvalTable {
+private:
+  ENTRY *et;
+  U64 et_size;        // number of entries (0 when the cache is switched off)
+  size_t et_bytes;
+  int et_mb;          // size in megabytes, as requested
+public:
+  void Alloc(int mbsize);
+  int GetSizeMb(void) { return et_mb; }
+  void Clear(void);
+  int Probe(U64 key, int *score, int *estimate, int *isExact);
+  void Store(U64 key, int score, int estimate, int isExact);
+};
+
+extern sEvalTable EvalTable;
@@ -19,58 +19,22 @@
 
 #include <string.h>
 #include <stdio.h>
-#if defined(_WIN32) || defined(_WIN64)
-#  include <windows.h>
-#else
-#  include <unistd.h>
-#  include <sys/time.h>
-#endif
 #include "data.h"
 #include "rodent.h"
 
-int InputAvailable(void)
-{
-#if defined(_WIN32) || defined(_WIN64)
-  static int init = 0, pipe;
-  static HANDLE inh;
-  DWORD dw;
-
-  if (!init) {
-    init = 1;
-    inh = GetStdHandle(STD_INPUT_HANDLE);
-    pipe = !GetConsoleMode(inh, &dw);
-    if (!pipe) {
-      SetConsoleMode(inh, dw & ~(ENABLE_MOUSE_INPUT | ENABLE_WINDOW_INPUT));
-      FlushConsoleInputBuffer(inh);
-    }
-  }
-  if (pipe) {
-    if (!PeekNamedPipe(inh, NULL, 0, NULL, &dw, NULL))
-      return 1;
-    return dw > 0;
-  } else {
-    GetNumberOfConsoleInputEvents(inh, &dw);
-    return dw > 1;
-  }
-#else
-  fd_set readfds;
-  struct timeval tv;
-
-  FD_ZERO(&readfds);
-  FD_SET(STDIN_FILENO, &readfds);
-  tv.tv_sec = 0;
-  tv.tv_usec = 0;
-  select(STDIN_FILENO + 1, &readfds, NULL, NULL, &tv);
-  return FD_ISSET(STDIN_FILENO, &readfds);
-#endif
-}
+// SplitMix64 generator (Sebastiano Vigna), used for Zobrist keys. Unlike
+// the linear congruential generator used before, all of its output bits
+// are of good quality, which matters as different bits of the key select
+// the TT bucket, the pawn hash slot and the book entry.
 
 U64 Random64(void)
 {
-  static U64 next = 1;
+  static U64 next = ZOBRIST_SEED;
 
-  next = next * 1103515245 + 12345;
-  return next;
+  U64 z = (next += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
 }
 
 void MoveToStr(int move, char *moveString)